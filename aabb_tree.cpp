@@ -0,0 +1,309 @@
+#include "aabb_tree.h"
+
+#include <algorithm>
+
+static inline aabb combine(aabb a, aabb b)
+{
+	return aabb{ { std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y) }, { std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y) } };
+}
+
+static inline aabb grow(aabb b, fixp margin)
+{
+	return aabb{ { b.min.x - margin, b.min.y - margin }, { b.max.x + margin, b.max.y + margin } };
+}
+
+static inline bool contains(aabb outer, aabb inner)
+{
+	return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+// Half the perimeter, which is what the insertion costs are measured in
+static inline int64_t perimeter(aabb b)
+{
+	return (b.max.x - b.min.x).val + (b.max.y - b.min.y).val;
+}
+
+int32_t aabb_tree::allocate()
+{
+	if (free_list == null_node)
+	{
+		const int32_t old = nodes.size();
+		const int32_t size = std::max(16, old * 2);
+		nodes.resize(size);
+		for (int32_t i = old; i < size; i++) { nodes[i].parent = i + 1 < size ? i + 1 : null_node; nodes[i].height = -1; }
+		free_list = old;
+	}
+	const int32_t i = free_list;
+	node& n = nodes[i];
+	free_list = n.parent;
+	n.parent = n.child1 = n.child2 = null_node;
+	n.height = 0;
+	n.user = 0;
+	return i;
+}
+
+void aabb_tree::release(int32_t i)
+{
+	nodes[i].parent = free_list;
+	nodes[i].height = -1;
+	free_list = i;
+}
+
+int32_t aabb_tree::insert(aabb box, uint32_t user)
+{
+	assert(box.min.x <= box.max.x && box.min.y <= box.max.y);
+	const int32_t id = allocate();
+	nodes[id].tight = box;
+	nodes[id].box = grow(box, fat_margin);
+	nodes[id].user = user;
+	insert_leaf(id);
+	count++;
+	return id;
+}
+
+void aabb_tree::remove(int32_t id)
+{
+	assert(is_leaf(id));
+	remove_leaf(id);
+	release(id);
+	count--;
+}
+
+bool aabb_tree::move(int32_t id, aabb box)
+{
+	assert(is_leaf(id));
+	assert(box.min.x <= box.max.x && box.min.y <= box.max.y);
+	node& n = nodes[id];
+	n.tight = box;
+	// Keep the old grown box while the new one fits, unless it has become a lot bigger than needed, like after shrinking
+	if (contains(n.box, box) && contains(grow(box, fat_margin * 4), n.box)) return false;
+	remove_leaf(id);
+	nodes[id].box = grow(box, fat_margin);
+	insert_leaf(id);
+	return true;
+}
+
+// See Box2D's b2DynamicTree, which this follows closely
+void aabb_tree::insert_leaf(int32_t leaf)
+{
+	if (root == null_node)
+	{
+		root = leaf;
+		nodes[root].parent = null_node;
+		return;
+	}
+
+	// Walk down to the sibling that grows the tree the least. Ties go to child2, so that this only depends on the boxes.
+	const aabb leaf_box = nodes[leaf].box;
+	int32_t index = root;
+	while (nodes[index].height > 0)
+	{
+		const node& n = nodes[index];
+		const int64_t area = perimeter(n.box);
+		const int64_t combined = perimeter(combine(n.box, leaf_box));
+		const int64_t cost = 2 * combined; // of making a new parent for this node and the leaf
+		const int64_t inheritance = 2 * (combined - area); // that all nodes below here pay for growing this one
+		const auto child_cost = [&](int32_t c)
+		{
+			const int64_t p = perimeter(combine(leaf_box, nodes[c].box));
+			return nodes[c].height == 0 ? p + inheritance : p - perimeter(nodes[c].box) + inheritance;
+		};
+		const int64_t cost1 = child_cost(n.child1);
+		const int64_t cost2 = child_cost(n.child2);
+		if (cost < cost1 && cost < cost2) break;
+		index = cost1 < cost2 ? n.child1 : n.child2;
+	}
+	const int32_t sibling = index;
+
+	const int32_t old_parent = nodes[sibling].parent;
+	const int32_t new_parent = allocate();
+	node& p = nodes[new_parent];
+	p.parent = old_parent;
+	p.box = combine(leaf_box, nodes[sibling].box);
+	p.height = nodes[sibling].height + 1;
+	p.child1 = sibling;
+	p.child2 = leaf;
+	nodes[sibling].parent = new_parent;
+	nodes[leaf].parent = new_parent;
+	if (old_parent == null_node) root = new_parent;
+	else if (nodes[old_parent].child1 == sibling) nodes[old_parent].child1 = new_parent;
+	else nodes[old_parent].child2 = new_parent;
+
+	for (index = nodes[leaf].parent; index != null_node; index = nodes[index].parent)
+	{
+		index = balance(index);
+		node& n = nodes[index];
+		n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+		n.box = combine(nodes[n.child1].box, nodes[n.child2].box);
+	}
+}
+
+void aabb_tree::remove_leaf(int32_t leaf)
+{
+	if (leaf == root)
+	{
+		root = null_node;
+		return;
+	}
+	const int32_t parent = nodes[leaf].parent;
+	const int32_t grand_parent = nodes[parent].parent;
+	const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+	release(parent);
+	if (grand_parent == null_node)
+	{
+		root = sibling;
+		nodes[sibling].parent = null_node;
+		return;
+	}
+	if (nodes[grand_parent].child1 == parent) nodes[grand_parent].child1 = sibling;
+	else nodes[grand_parent].child2 = sibling;
+	nodes[sibling].parent = grand_parent;
+	for (int32_t index = grand_parent; index != null_node; index = nodes[index].parent)
+	{
+		index = balance(index);
+		node& n = nodes[index];
+		n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+		n.box = combine(nodes[n.child1].box, nodes[n.child2].box);
+	}
+}
+
+// If one child of 'ia' is more than one level taller than the other, rotate it up. Returns the index of the node now in its place.
+int32_t aabb_tree::balance(int32_t ia)
+{
+	node& a = nodes[ia];
+	if (a.height < 2) return ia;
+	const int32_t ib = a.child1;
+	const int32_t ic = a.child2;
+	node& b = nodes[ib];
+	node& c = nodes[ic];
+	const int32_t diff = c.height - b.height;
+
+	if (diff > 1) // rotate c up
+	{
+		const int32_t i_f = c.child1;
+		const int32_t ig = c.child2;
+		node& f = nodes[i_f];
+		node& g = nodes[ig];
+		c.child1 = ia;
+		c.parent = a.parent;
+		a.parent = ic;
+		if (c.parent == null_node) root = ic;
+		else if (nodes[c.parent].child1 == ia) nodes[c.parent].child1 = ic;
+		else nodes[c.parent].child2 = ic;
+		if (f.height > g.height)
+		{
+			c.child2 = i_f;
+			a.child2 = ig;
+			g.parent = ia;
+			a.box = combine(b.box, g.box);
+			c.box = combine(a.box, f.box);
+			a.height = 1 + std::max(b.height, g.height);
+			c.height = 1 + std::max(a.height, f.height);
+		}
+		else
+		{
+			c.child2 = ig;
+			a.child2 = i_f;
+			f.parent = ia;
+			a.box = combine(b.box, f.box);
+			c.box = combine(a.box, g.box);
+			a.height = 1 + std::max(b.height, f.height);
+			c.height = 1 + std::max(a.height, g.height);
+		}
+		return ic;
+	}
+
+	if (diff < -1) // rotate b up
+	{
+		const int32_t id = b.child1;
+		const int32_t ie = b.child2;
+		node& d = nodes[id];
+		node& e = nodes[ie];
+		b.child1 = ia;
+		b.parent = a.parent;
+		a.parent = ib;
+		if (b.parent == null_node) root = ib;
+		else if (nodes[b.parent].child1 == ia) nodes[b.parent].child1 = ib;
+		else nodes[b.parent].child2 = ib;
+		if (d.height > e.height)
+		{
+			b.child2 = id;
+			a.child1 = ie;
+			e.parent = ia;
+			a.box = combine(c.box, e.box);
+			b.box = combine(a.box, d.box);
+			a.height = 1 + std::max(c.height, e.height);
+			b.height = 1 + std::max(a.height, d.height);
+		}
+		else
+		{
+			b.child2 = ie;
+			a.child1 = id;
+			d.parent = ia;
+			a.box = combine(c.box, d.box);
+			b.box = combine(a.box, e.box);
+			a.height = 1 + std::max(c.height, d.height);
+			b.height = 1 + std::max(a.height, e.height);
+		}
+		return ib;
+	}
+	return ia;
+}
+
+// Narrow [enter, leave] to where the segment from 'a' to 'b' is inside [lo, hi] along one axis
+static inline bool clip_axis(fixp a, fixp b, fixp lo, fixp hi, fixp& enter, fixp& leave)
+{
+	if (a < lo) { if (b < lo) return false; enter = std::max(enter, fixp_intersect(a - lo, b - lo)); }
+	else if (a > hi) { if (b > hi) return false; enter = std::max(enter, fixp_intersect(a - hi, b - hi)); }
+	if (b > hi) leave = std::min(leave, fixp_intersect(a - hi, b - hi));
+	else if (b < lo) leave = std::min(leave, fixp_intersect(a - lo, b - lo));
+	return true;
+}
+
+bool aabb_tree::segment_enters(aabb b, ivec2 from, ivec2 to, fixp& t)
+{
+	fixp enter = 0, leave = 1;
+	if (!clip_axis(from.x, to.x, b.min.x, b.max.x, enter, leave)) return false;
+	if (!clip_axis(from.y, to.y, b.min.y, b.max.y, enter, leave)) return false;
+	if (enter > leave) return false;
+	t = enter;
+	return true;
+}
+
+int32_t aabb_tree::raycast(ivec2 from, ivec2 to, fixp& t) const
+{
+	int32_t best = null_node;
+	fixp best_t = 1;
+	fixp entry;
+	traverse([&](aabb b) { return segment_enters(b, from, to, entry) && entry <= best_t; }, [](int32_t) { return true; }, [&](int32_t id)
+	{
+		if (segment_enters(nodes[id].tight, from, to, entry) && (best == null_node || entry < best_t || (entry == best_t && id < best))) { best = id; best_t = entry; }
+		return true;
+	});
+	if (best != null_node) t = best_t;
+	return best;
+}
+
+// Returns the number of leaves below 'i', or -1 if something is wrong
+int32_t aabb_tree::validate(int32_t i, int32_t parent) const
+{
+	const node& n = nodes[i];
+	if (n.parent != parent || n.height < 0) return -1;
+	if (n.height == 0) return contains(n.box, n.tight) ? 1 : -1;
+	const int32_t l1 = validate(n.child1, i);
+	const int32_t l2 = validate(n.child2, i);
+	if (l1 < 0 || l2 < 0) return -1;
+	if (n.height != 1 + std::max(nodes[n.child1].height, nodes[n.child2].height)) return -1;
+	if (std::abs(nodes[n.child1].height - nodes[n.child2].height) > 1) return -1;
+	const aabb u = combine(nodes[n.child1].box, nodes[n.child2].box);
+	if (u.min.x != n.box.min.x || u.min.y != n.box.min.y || u.max.x != n.box.max.x || u.max.y != n.box.max.y) return -1;
+	return l1 + l2;
+}
+
+bool aabb_tree::validate() const
+{
+	int32_t free = 0;
+	for (int32_t i = free_list; i != null_node; i = nodes[i].parent) { if (nodes[i].height != -1) return false; free++; }
+	if (root == null_node) return count == 0 && free == (int32_t)nodes.size();
+	return validate(root, null_node) == count && 2 * count - 1 + free == (int32_t)nodes.size();
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+// A dynamic bounding volume hierarchy over fixed point boxes, for region, radius and ray queries over many moving things.
+//
+// Each entry is stored as a leaf with its box grown by a margin, so that small moves do not change the tree at all. Leaves are inserted
+// next to the sibling that grows the tree the least, and the tree is kept balanced with rotations, so inserts, removals and moves take
+// O(log n). Nodes come from a pool inside the tree that only grows when it runs out.
+//
+// Everything is integer math, so the same sequence of calls builds the same tree everywhere, and queries visit entries in the same order
+// everywhere, which is what lockstep simulations need.
+
+#include "fixp.h"
+
+#include <vector>
+
+class aabb_tree
+{
+public:
+	static constexpr int32_t null_node = -1;
+
+	/// Every box is grown by 'margin' on all sides when stored.
+	explicit aabb_tree(fixp margin = fixp(0)) : fat_margin(margin) { assert(margin.val >= 0); }
+
+	/// Add a box with a value of your own, like an entity index. Returns an id for it, which stays the same until it is removed.
+	int32_t insert(aabb box, uint32_t user);
+	/// Remove an entry by its id. The id may be reused by a later insert.
+	void remove(int32_t id);
+	/// Change the box of an entry. Returns true if it left its grown box, so that the tree had to be changed.
+	bool move(int32_t id, aabb box);
+
+	inline aabb box(int32_t id) const { assert(is_leaf(id)); return nodes[id].tight; }
+	inline aabb fat_box(int32_t id) const { assert(is_leaf(id)); return nodes[id].box; }
+	inline uint32_t user(int32_t id) const { assert(is_leaf(id)); return nodes[id].user; }
+	inline int32_t size() const { return count; }
+	/// Height of the tree, zero when it only has a single entry.
+	inline int32_t height() const { return root == null_node ? 0 : nodes[root].height; }
+
+	/// Call 'visit(id)' for every entry whose box overlaps 'region', until it returns false.
+	template<typename F> void query(aabb region, F&& visit) const
+	{
+		traverse([&](aabb b) { return fixp_overlaps(b, region); }, [&](int32_t id) { return visit(id); });
+	}
+
+	/// Call 'visit(id)' for every entry whose box is within 'radius' of 'center', until it returns false. Squared distances are
+	/// compared in 128 bits, so this is exact for any coordinates and radius.
+	template<typename F> void query_radius(ivec2 center, fixp radius, F&& visit) const
+	{
+		const __int128 r2 = (__int128)radius.val * radius.val;
+		traverse([&](aabb b) { return distance_sq(b, center) <= r2; }, [&](int32_t id) { return visit(id); });
+	}
+
+	/// Call 'visit(id, t)' for every entry whose box is hit by the line segment from 'from' to 'to', where 't' is how far along the
+	/// segment it enters the box from 0 to 1, until it returns false.
+	template<typename F> void query_ray(ivec2 from, ivec2 to, F&& visit) const
+	{
+		fixp t;
+		traverse([&](aabb b) { return segment_enters(b, from, to, t); }, [&](int32_t) { return true; }, [&](int32_t id) { return !segment_enters(nodes[id].tight, from, to, t) || visit(id, t); });
+	}
+
+	/// The same as above, but collecting the ids.
+	void query(aabb region, std::vector<int32_t>& out) const { query(region, [&](int32_t id) { out.push_back(id); return true; }); }
+	void query_radius(ivec2 center, fixp radius, std::vector<int32_t>& out) const { query_radius(center, radius, [&](int32_t id) { out.push_back(id); return true; }); }
+
+	/// The first entry hit by the line segment from 'from' to 'to', or null_node if none is. Sets 't' to how far along the segment it is
+	/// hit, and if several are hit at the same place, the lowest id wins.
+	int32_t raycast(ivec2 from, ivec2 to, fixp& t) const;
+
+	/// Where the segment from 'from' to 'to' enters 'b', as a fraction of its length. Uses fixp_intersect, and only on edges that are
+	/// actually crossed, so it never overflows.
+	static bool segment_enters(aabb b, ivec2 from, ivec2 to, fixp& t);
+
+	/// Squared distance from 'p' to the nearest point in 'b', on raw values.
+	static inline __int128 distance_sq(aabb b, ivec2 p)
+	{
+		const __int128 dx = p.x < b.min.x ? (__int128)b.min.x.val - p.x.val : p.x > b.max.x ? (__int128)p.x.val - b.max.x.val : 0;
+		const __int128 dy = p.y < b.min.y ? (__int128)b.min.y.val - p.y.val : p.y > b.max.y ? (__int128)p.y.val - b.max.y.val : 0;
+		return dx * dx + dy * dy;
+	}
+
+	/// Check that the tree is consistent, for tests.
+	bool validate() const;
+
+private:
+	struct node
+	{
+		aabb box; // grown box for leaves, the union of the children for the others
+		aabb tight; // the box as given, for leaves only
+		int32_t parent; // or the next free node, for free nodes
+		int32_t child1;
+		int32_t child2;
+		int32_t height; // zero for leaves, and -1 for free nodes
+		uint32_t user;
+	};
+
+	inline bool is_leaf(int32_t id) const { return id >= 0 && id < (int32_t)nodes.size() && nodes[id].height == 0; }
+
+	/// Depth first, always child1 before child2. 'enter' decides on each box, 'inner' may stop early at a branch, and 'leaf' at a leaf.
+	template<typename E, typename I, typename L> void traverse(E&& enter, I&& inner, L&& leaf) const
+	{
+		if (root == null_node) return;
+		int32_t stack[128]; // the tree is balanced, so this is enough for more entries than fit in memory
+		int top = 0;
+		stack[top++] = root;
+		while (top > 0)
+		{
+			const int32_t i = stack[--top];
+			const node& n = nodes[i];
+			if (!enter(n.box)) continue;
+			if (n.height == 0) { if (!leaf(i)) return; continue; }
+			if (!inner(i)) return;
+			assert(top + 2 <= 128);
+			stack[top++] = n.child2;
+			stack[top++] = n.child1;
+		}
+	}
+
+	template<typename E, typename L> void traverse(E&& enter, L&& visit) const
+	{
+		traverse(enter, [](int32_t) { return true; }, [&](int32_t id) { return !enter(nodes[id].tight) || visit(id); });
+	}
+
+	int32_t allocate();
+	void release(int32_t i);
+	void insert_leaf(int32_t leaf);
+	void remove_leaf(int32_t leaf);
+	int32_t balance(int32_t a);
+	int32_t validate(int32_t i, int32_t parent) const;
+
+	std::vector<node> nodes;
+	int32_t root = null_node;
+	int32_t free_list = null_node;
+	int32_t count = 0;
+	fixp fat_margin;
+};
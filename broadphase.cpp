@@ -0,0 +1,127 @@
+#include "broadphase.h"
+
+namespace
+{
+	struct broadphase_kernels
+	{
+		void (*overlaps)(int64_t x0, int64_t y0, int64_t x1, int64_t y1, const int64_t* min_x, const int64_t* min_y, const int64_t* max_x, const int64_t* max_y, uint64_t* mask, size_t n);
+		void (*overlaps16)(int32_t x0, int32_t y0, int32_t x1, int32_t y1, const int32_t* min_x, const int32_t* min_y, const int32_t* max_x, const int32_t* max_y, uint64_t* mask, size_t n);
+	};
+}
+
+#define DICEY_OVERLAPS(level, attr) \
+	attr static void overlaps_##level(int64_t x0, int64_t y0, int64_t x1, int64_t y1, const int64_t* min_x, const int64_t* min_y, const int64_t* max_x, const int64_t* max_y, uint64_t* mask, size_t n) \
+		{ fixp_overlaps_raw(x0, y0, x1, y1, min_x, min_y, max_x, max_y, mask, n); } \
+	attr static void overlaps16_##level(int32_t x0, int32_t y0, int32_t x1, int32_t y1, const int32_t* min_x, const int32_t* min_y, const int32_t* max_x, const int32_t* max_y, uint64_t* mask, size_t n) \
+		{ fixp_overlaps_raw(x0, y0, x1, y1, min_x, min_y, max_x, max_y, mask, n); }
+
+DICEY_OVERLAPS(scalar, )
+static const broadphase_kernels kernels_scalar = { overlaps_scalar, overlaps16_scalar };
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+
+// Compilers do not turn the packing of the results into a bitmask into the movemask and mask register instructions made for it, so we
+// write these out by hand. Whole blocks of 64 boxes are done here, and the generic code does the rest.
+
+DICEY_AVX2 static void overlaps_avx2(int64_t x0, int64_t y0, int64_t x1, int64_t y1, const int64_t* min_x, const int64_t* min_y, const int64_t* max_x, const int64_t* max_y, uint64_t* mask, size_t n)
+{
+	const __m256i vx0 = _mm256_set1_epi64x(x0), vy0 = _mm256_set1_epi64x(y0), vx1 = _mm256_set1_epi64x(x1), vy1 = _mm256_set1_epi64x(y1);
+	const size_t full = n & ~(size_t)63;
+	for (size_t base = 0; base < full; base += 64)
+	{
+		uint64_t bits = 0;
+		for (int k = 0; k < 64; k += 4)
+		{
+			const size_t i = base + k;
+			__m256i miss = _mm256_cmpgt_epi64(_mm256_loadu_si256((const __m256i*)(min_x + i)), vx1);
+			miss = _mm256_or_si256(miss, _mm256_cmpgt_epi64(vx0, _mm256_loadu_si256((const __m256i*)(max_x + i))));
+			miss = _mm256_or_si256(miss, _mm256_cmpgt_epi64(_mm256_loadu_si256((const __m256i*)(min_y + i)), vy1));
+			miss = _mm256_or_si256(miss, _mm256_cmpgt_epi64(vy0, _mm256_loadu_si256((const __m256i*)(max_y + i))));
+			bits |= (uint64_t)(~_mm256_movemask_pd(_mm256_castsi256_pd(miss)) & 0xf) << k;
+		}
+		mask[base / 64] = bits;
+	}
+	fixp_overlaps_raw(x0, y0, x1, y1, min_x + full, min_y + full, max_x + full, max_y + full, mask + full / 64, n - full);
+}
+
+DICEY_AVX2 static void overlaps16_avx2(int32_t x0, int32_t y0, int32_t x1, int32_t y1, const int32_t* min_x, const int32_t* min_y, const int32_t* max_x, const int32_t* max_y, uint64_t* mask, size_t n)
+{
+	const __m256i vx0 = _mm256_set1_epi32(x0), vy0 = _mm256_set1_epi32(y0), vx1 = _mm256_set1_epi32(x1), vy1 = _mm256_set1_epi32(y1);
+	const size_t full = n & ~(size_t)63;
+	for (size_t base = 0; base < full; base += 64)
+	{
+		uint64_t bits = 0;
+		for (int k = 0; k < 64; k += 8)
+		{
+			const size_t i = base + k;
+			__m256i miss = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)(min_x + i)), vx1);
+			miss = _mm256_or_si256(miss, _mm256_cmpgt_epi32(vx0, _mm256_loadu_si256((const __m256i*)(max_x + i))));
+			miss = _mm256_or_si256(miss, _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)(min_y + i)), vy1));
+			miss = _mm256_or_si256(miss, _mm256_cmpgt_epi32(vy0, _mm256_loadu_si256((const __m256i*)(max_y + i))));
+			bits |= (uint64_t)(~_mm256_movemask_ps(_mm256_castsi256_ps(miss)) & 0xff) << k;
+		}
+		mask[base / 64] = bits;
+	}
+	fixp_overlaps_raw(x0, y0, x1, y1, min_x + full, min_y + full, max_x + full, max_y + full, mask + full / 64, n - full);
+}
+
+DICEY_AVX512 static void overlaps_avx512(int64_t x0, int64_t y0, int64_t x1, int64_t y1, const int64_t* min_x, const int64_t* min_y, const int64_t* max_x, const int64_t* max_y, uint64_t* mask, size_t n)
+{
+	const __m512i vx0 = _mm512_set1_epi64(x0), vy0 = _mm512_set1_epi64(y0), vx1 = _mm512_set1_epi64(x1), vy1 = _mm512_set1_epi64(y1);
+	const size_t full = n & ~(size_t)63;
+	for (size_t base = 0; base < full; base += 64)
+	{
+		uint64_t bits = 0;
+		for (int k = 0; k < 64; k += 8)
+		{
+			const size_t i = base + k;
+			__mmask8 m = _mm512_cmple_epi64_mask(_mm512_loadu_si512(min_x + i), vx1);
+			m = _mm512_mask_cmple_epi64_mask(m, vx0, _mm512_loadu_si512(max_x + i));
+			m = _mm512_mask_cmple_epi64_mask(m, _mm512_loadu_si512(min_y + i), vy1);
+			m = _mm512_mask_cmple_epi64_mask(m, vy0, _mm512_loadu_si512(max_y + i));
+			bits |= (uint64_t)m << k;
+		}
+		mask[base / 64] = bits;
+	}
+	fixp_overlaps_raw(x0, y0, x1, y1, min_x + full, min_y + full, max_x + full, max_y + full, mask + full / 64, n - full);
+}
+
+DICEY_AVX512 static void overlaps16_avx512(int32_t x0, int32_t y0, int32_t x1, int32_t y1, const int32_t* min_x, const int32_t* min_y, const int32_t* max_x, const int32_t* max_y, uint64_t* mask, size_t n)
+{
+	const __m512i vx0 = _mm512_set1_epi32(x0), vy0 = _mm512_set1_epi32(y0), vx1 = _mm512_set1_epi32(x1), vy1 = _mm512_set1_epi32(y1);
+	const size_t full = n & ~(size_t)63;
+	for (size_t base = 0; base < full; base += 64)
+	{
+		uint64_t bits = 0;
+		for (int k = 0; k < 64; k += 16)
+		{
+			const size_t i = base + k;
+			__mmask16 m = _mm512_cmple_epi32_mask(_mm512_loadu_si512(min_x + i), vx1);
+			m = _mm512_mask_cmple_epi32_mask(m, vx0, _mm512_loadu_si512(max_x + i));
+			m = _mm512_mask_cmple_epi32_mask(m, _mm512_loadu_si512(min_y + i), vy1);
+			m = _mm512_mask_cmple_epi32_mask(m, vy0, _mm512_loadu_si512(max_y + i));
+			bits |= (uint64_t)m << k;
+		}
+		mask[base / 64] = bits;
+	}
+	fixp_overlaps_raw(x0, y0, x1, y1, min_x + full, min_y + full, max_x + full, max_y + full, mask + full / 64, n - full);
+}
+
+DICEY_OVERLAPS(sse42, DICEY_SSE42)
+static const broadphase_kernels kernels_sse42 = { overlaps_sse42, overlaps16_sse42 };
+static const broadphase_kernels kernels_avx2 = { overlaps_avx2, overlaps16_avx2 };
+static const broadphase_kernels kernels_avx512 = { overlaps_avx512, overlaps16_avx512 };
+static const broadphase_kernels* const kernel_table[] = { &kernels_scalar, &kernels_sse42, &kernels_avx2, &kernels_avx512 };
+#else
+static const broadphase_kernels* const kernel_table[] = { &kernels_scalar, &kernels_scalar, &kernels_scalar, &kernels_scalar };
+#endif
+
+void fixp_overlaps_n(aabb box, const aabb_soa& boxes, uint64_t* mask)
+{
+	kernel_table[(int)cpu_level_active()]->overlaps(box.min.x.val, box.min.y.val, box.max.x.val, box.max.y.val, boxes.min_x.data(), boxes.min_y.data(), boxes.max_x.data(), boxes.max_y.data(), mask, boxes.size());
+}
+
+void fixp_overlaps_n(aabb16 box, const aabb16_soa& boxes, uint64_t* mask)
+{
+	kernel_table[(int)cpu_level_active()]->overlaps16(box.min.x.val, box.min.y.val, box.max.x.val, box.max.y.val, boxes.min_x.data(), boxes.min_y.data(), boxes.max_x.data(), boxes.max_y.data(), mask, boxes.size());
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+// Broad phase collision detection on fixed point boxes: finding which of many boxes may touch, before any exact tests.
+//
+// Boxes are stored as separate arrays of their four edges. fixp_overlaps_n tests one box against all of them at once, and
+// fixed_sweep_and_prune finds all overlapping pairs. Both give exactly the same answers as fixp_overlaps in fixp.h, so touching boxes
+// overlap.
+
+#include "fixp.h"
+
+#include <algorithm>
+#include <vector>
+
+template<typename T>
+struct fixed_aabb_soa
+{
+	using storage = typename T::storage;
+
+	fixed_aabb_soa() {}
+	explicit fixed_aabb_soa(size_t n) : min_x(n, 0), min_y(n, 0), max_x(n, 0), max_y(n, 0) {}
+
+	inline size_t size() const { return min_x.size(); }
+	void resize(size_t n) { min_x.resize(n, 0); min_y.resize(n, 0); max_x.resize(n, 0); max_y.resize(n, 0); }
+	void reserve(size_t n) { min_x.reserve(n); min_y.reserve(n); max_x.reserve(n); max_y.reserve(n); }
+	void push_back(fixed_aabb<T> b) { min_x.push_back(b.min.x.val); min_y.push_back(b.min.y.val); max_x.push_back(b.max.x.val); max_y.push_back(b.max.y.val); }
+	inline fixed_aabb<T> get(size_t i) const { fixed_aabb<T> b; b.min.x.val = min_x[i]; b.min.y.val = min_y[i]; b.max.x.val = max_x[i]; b.max.y.val = max_y[i]; return b; }
+	inline void set(size_t i, fixed_aabb<T> b) { min_x[i] = b.min.x.val; min_y[i] = b.min.y.val; max_x[i] = b.max.x.val; max_y[i] = b.max.y.val; }
+
+	std::vector<storage> min_x;
+	std::vector<storage> min_y;
+	std::vector<storage> max_x;
+	std::vector<storage> max_y;
+};
+
+using aabb_soa = fixed_aabb_soa<fixp>;
+using aabb16_soa = fixed_aabb_soa<fixp16>;
+
+/// Two overlapping boxes by index, with a < b.
+struct box_pair
+{
+	uint32_t a;
+	uint32_t b;
+
+	auto operator<=>(const box_pair&) const = default;
+};
+
+// -- One versus many --
+
+/// The overlap kernel on raw arrays. Always inlined, so that each instruction set level in broadphase.cpp gets its own copy.
+template<typename S> static inline __attribute__((always_inline)) void fixp_overlaps_raw(S x0, S y0, S x1, S y1, const S* min_x, const S* min_y, const S* max_x, const S* max_y, uint64_t* mask, size_t n)
+{
+	for (size_t base = 0; base < n; base += 64)
+	{
+		const size_t m = std::min<size_t>(64, n - base);
+		uint64_t bits = 0;
+		for (size_t j = 0; j < m; j++)
+		{
+			const size_t i = base + j;
+			const uint64_t hit = (min_x[i] <= x1) & (x0 <= max_x[i]) & (min_y[i] <= y1) & (y0 <= max_y[i]);
+			bits |= hit << j;
+		}
+		mask[base / 64] = bits;
+	}
+}
+
+/// Set bit i of 'mask' when boxes[i] overlaps 'box', and clear it otherwise. 'mask' needs room for (boxes.size() + 63) / 64 words, and
+/// the unused bits of the last one are cleared. The template works for any layout, while the overloads for aabb and aabb16 below it
+/// use the best instruction set the CPU has.
+template<typename T> static inline void fixp_overlaps_n(fixed_aabb<T> box, const fixed_aabb_soa<T>& boxes, uint64_t* mask)
+{
+	fixp_overlaps_raw(box.min.x.val, box.min.y.val, box.max.x.val, box.max.y.val, boxes.min_x.data(), boxes.min_y.data(), boxes.max_x.data(), boxes.max_y.data(), mask, boxes.size());
+}
+
+void fixp_overlaps_n(aabb box, const aabb_soa& boxes, uint64_t* mask);
+void fixp_overlaps_n(aabb16 box, const aabb16_soa& boxes, uint64_t* mask);
+
+// -- Sweep and prune --
+
+/// Finds all overlapping pairs of boxes by sorting them on their left edge, after which each box only needs to be tested against the
+/// following boxes that start before it ends. The order is kept between calls and fixed up with an insertion sort, so when boxes only
+/// move a little from one frame to the next, as they usually do, sorting costs close to nothing.
+template<typename T>
+class fixed_sweep_and_prune
+{
+public:
+	using storage = typename T::storage;
+
+	/// Find all overlapping pairs among 'boxes', identified by their index, in sorted order. The result only depends on the boxes and
+	/// not on earlier calls. Boxes added since the last call are given at the end, and if there are fewer than before, the ones past
+	/// the end are dropped. The returned list is valid until the next call.
+	const std::vector<box_pair>& update(const fixed_aabb_soa<T>& boxes)
+	{
+		const uint32_t n = boxes.size();
+		if (n < count) order.erase(std::remove_if(order.begin(), order.end(), [n](uint32_t id) { return id >= n; }), order.end());
+		for (uint32_t id = count; id < n; id++) order.push_back(id);
+		count = n;
+
+		// Insertion sort on the left edge, with ties broken by index so that the order is total. If boxes were shuffled around a lot, like
+		// on the first call, we give up on it and sort from scratch.
+		const storage* min_x = boxes.min_x.data();
+		const auto before = [min_x](uint32_t a, uint32_t b) { return min_x[a] < min_x[b] || (min_x[a] == min_x[b] && a < b); };
+		uint32_t* ids = order.data();
+		size_t moves = 0;
+		for (uint32_t i = 1; i < n && moves <= 4 * (size_t)n; i++)
+		{
+			const uint32_t id = ids[i];
+			uint32_t j = i;
+			while (j > 0 && before(id, ids[j - 1])) { ids[j] = ids[j - 1]; j--; }
+			ids[j] = id;
+			moves += i - j;
+		}
+		if (moves > 4 * (size_t)n) std::sort(order.begin(), order.end(), before);
+		moved = moves;
+
+		// Gather the boxes in sorted order, so the sweep reads memory in order
+		x0.resize(n); x1.resize(n); y0.resize(n); y1.resize(n);
+		storage* __restrict sx0 = x0.data();
+		storage* __restrict sx1 = x1.data();
+		storage* __restrict sy0 = y0.data();
+		storage* __restrict sy1 = y1.data();
+		for (uint32_t i = 0; i < n; i++)
+		{
+			const uint32_t id = ids[i];
+			sx0[i] = min_x[id]; sx1[i] = boxes.max_x[id]; sy0[i] = boxes.min_y[id]; sy1[i] = boxes.max_y[id];
+		}
+
+		result.clear();
+		for (uint32_t i = 0; i < n; i++)
+		{
+			const storage end = sx1[i], bottom = sy0[i], top = sy1[i];
+			for (uint32_t j = i + 1; j < n && sx0[j] <= end; j++)
+			{
+				if ((sy0[j] <= top) & (bottom <= sy1[j])) result.push_back(ids[i] < ids[j] ? box_pair{ ids[i], ids[j] } : box_pair{ ids[j], ids[i] });
+			}
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	/// The pairs found by the last update.
+	inline const std::vector<box_pair>& pairs() const { return result; }
+
+	/// How many places boxes moved in the insertion sort during the last update. Small when the scene is coherent from frame to frame,
+	/// and more than four times the number of boxes when it gave up and sorted from scratch instead.
+	inline size_t sort_moves() const { return moved; }
+
+private:
+	uint32_t count = 0;
+	size_t moved = 0;
+	std::vector<uint32_t> order; // box indices sorted by left edge
+	std::vector<storage> x0, x1, y0, y1; // boxes in sorted order
+	std::vector<box_pair> result;
+};
+
+using sweep_and_prune = fixed_sweep_and_prune<fixp>;
+using sweep_and_prune16 = fixed_sweep_and_prune<fixp16>;
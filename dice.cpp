@@ -214,6 +214,7 @@ int seed::roll(int low, int high, luck_type luck, int jackpot_chance, int jackpo
 
 int roll_table::unique_rolls(int count, int* results, luck_type rollee_luck, int roll_weight, int start_index)
 {
+	DICEY_SCOPE("roll_table::unique_rolls");
 	if (count <= 0) return 0;
 	assert(size > 0);
 	assert(!table.empty());
@@ -264,7 +265,9 @@ int roll_table::unique_rolls(int count, int* results, luck_type rollee_luck, int
 	for (int i = 0; i < count; i++)
 	{
 		if (active_count <= i + start_index) return i; // ran out of options
+		DICEY_STAT(uint64_t tries = 0;)
 repeat:
+		DICEY_STAT(tries++;)
 		const int r = s.roll(roll_weight, size - roll_weight, rollee_luck);
 		const int k = lookup(r);
 		if (use_set)
@@ -284,6 +287,7 @@ repeat:
 				if (results[j] == k) goto repeat;
 			}
 		}
+		DICEY_STAT(telemetry.unique_rolls.record(tries);)
 		results[start_index + i] = k;
 	}
 	return count;
@@ -291,6 +295,7 @@ repeat:
 
 int roll_table::rolls(int count, int* results, luck_type rollee_luck, int roll_weight)
 {
+	DICEY_SCOPE("roll_table::rolls");
 	if (count <= 0) return 0;
 	assert(size > 0);
 	assert(!table.empty());
@@ -308,6 +313,7 @@ int roll_table::rolls(int count, int* results, luck_type rollee_luck, int roll_w
 
 int roll_table::boxgacha(luck_type rollee_luck, int roll_weight)
 {
+	DICEY_SCOPE("roll_table::boxgacha");
 	if (active_count == 0) return -1;
 	assert(size > 0);
 	roll_weight = std::clamp(roll_weight, 0, 128);
@@ -318,14 +324,211 @@ int roll_table::boxgacha(luck_type rollee_luck, int roll_weight)
 		[](int k, const std::pair<int, int>& p) { return k < p.first; });
 	if (it == table.end()) it = table.begin();
 
-	while (it != table.end() && it->second < 0) { ++it; }
+	DICEY_STAT(uint64_t scanned = 1;)
+	while (it != table.end() && it->second < 0) { ++it; DICEY_STAT(scanned++;) }
 	if (it == table.end()) {
 		it = table.begin();
-		while (it != table.end() && it->second < 0) { ++it; }
+		while (it != table.end() && it->second < 0) { ++it; DICEY_STAT(scanned++;) }
 	}
+	DICEY_STAT(telemetry.boxgacha.record(scanned);)
 
 	const int ret = it->second;
 	it->second = -1;
 	active_count--;
 	return ret;
 }
+
+template<typename T> void linear_series::roll_lanes(int n, T* out)
+{
+	if (n < 64) { for (int i = 0; i < n; i++) out[i] = roll(); return; } // not worth building the stride table
+	uint64_t stride[256];
+	lfsr_stride_table(tap, stride);
+	while (n > 0)
+	{
+		const uint32_t want = std::min<uint64_t>(n, unused); // we must stop at the next reset
+		uint32_t got = 0;
+		uint64_t lane[8]; // lane j holds every eighth value, starting j + 1 steps ahead
+		lane[0] = x;
+		lfsr_next(lane[0], tap);
+		for (int j = 1; j < 8; j++) { lane[j] = lane[j - 1]; lfsr_next(lane[j], tap); }
+		while (got < want)
+		{
+			T buf[64];
+			T* dst = (want - got >= 64) ? out + got : buf; // compact straight into the output while there is room
+			int k = 0;
+			DICEY_STAT(uint64_t used = 0;) // candidates looked at up to the last one we keep
+			for (int i = 0; i < 64; i += 8)
+			{
+				for (int j = 0; j < 8; j++)
+				{
+					const T v = lane[j] - 1;
+					lane[j] = (lane[j] >> 8) ^ stride[lane[j] & 0xff];
+					dst[k] = v;
+					k += v < cur;
+					DICEY_STAT(if (!used && k == (int)(want - got)) used = i + j + 1;)
+				}
+			}
+			const uint32_t take = std::min<uint32_t>(k, want - got);
+			if (dst == buf) std::copy_n(buf, take, out + got);
+			DICEY_STAT(rejections.calls += take; rejections.attempts += used ? used : 64;)
+			got += take;
+			if (got == want) x = dst[take - 1] + 1; // rewind to the last value we actually used
+		}
+		out += want;
+		n -= want;
+		unused -= want;
+		if (unused == 0) reset();
+	}
+}
+
+void linear_series::roll_n(int n, uint32_t* out)
+{
+	DICEY_SCOPE("linear_series::roll_n");
+	assert(len <= (1ull << 32));
+	roll_lanes(n, out);
+}
+
+void linear_series::roll_n(int n, uint64_t* out)
+{
+	DICEY_SCOPE("linear_series::roll_n");
+	roll_lanes(n, out);
+}
+
+void linear_series::skip(uint64_t n)
+{
+	if (n >= unused) // only the seed needs to advance per whole series, the LFSR is set up once for the last one
+	{
+		n -= unused;
+		state = splitmix64(state);
+		for (; n >= cur; n -= cur) state = splitmix64(state);
+		x = lfsr_init(state, bits);
+		unused = cur;
+	}
+	if (n == 0) return;
+	if (cur == len - 1) // no rerolls possible, so jump; the first step is taken by hand since lfsr_init() may start us just outside the cycle
+	{
+		lfsr_next(x, tap);
+		x = lfsr_skip(x, tap, bits, n - 1);
+		unused -= n;
+	}
+	else for (; n > 0; n--) roll();
+}
+
+uint32_t prd_pool::add(const seed& orig, uint16_t probability)
+{
+	const prd p(orig, probability, func);
+	const uint32_t idx = size();
+	state.push_back(p.state);
+	accum.push_back(p.accum);
+	remainder.push_back(p.remainder);
+	chance.push_back(p.chance);
+	if (idx % 64 == 0) value.push_back(0);
+	value.back() |= (uint64_t)p.value << (idx % 64);
+	return idx;
+}
+
+// Count down the selected accumulators of 64 entries, and return a bitmask of the selected entries that were already empty.
+// Everything is kept in 16 bit lanes so that it vectorizes.
+static inline uint64_t prd_countdown64(uint16_t* a, uint64_t m)
+{
+	uint16_t sel[64];
+	uint16_t zero[64];
+	for (int i = 0; i < 64; i++) sel[i] = (m >> i) & 1;
+	uint16_t any = 0;
+	for (int i = 0; i < 64; i++)
+	{
+		const uint16_t nonzero = a[i] != 0;
+		zero[i] = sel[i] & !nonzero;
+		any |= zero[i];
+		a[i] -= sel[i] & nonzero;
+	}
+	uint64_t empty = 0;
+	if (any) for (int i = 0; i < 64; i++) empty |= (uint64_t)zero[i] << i;
+	return empty;
+}
+
+void prd_pool::roll_masked(const uint64_t* mask, uint64_t* result)
+{
+	DICEY_SCOPE("prd_pool::roll_masked");
+	const uint32_t n = size();
+	for (uint32_t w = 0; w < words(); w++)
+	{
+		const uint32_t base = w * 64;
+		const uint64_t m = mask[w] & (n - base >= 64 ? ~0ull : (1ull << (n - base)) - 1); // no bits past the end
+		if (!m) { result[w] = 0; continue; }
+		uint16_t* a = accum.data() + base;
+		uint64_t empty = 0;
+		if (n - base >= 64) // the common case, count down without branching
+		{
+			empty = prd_countdown64(a, m);
+		}
+		else for (uint32_t i = 0; i < n - base; i++)
+		{
+			if (!((m >> i) & 1)) continue;
+			if (a[i]) a[i]--;
+			else empty |= 1ull << i;
+		}
+		result[w] = m & ~(empty ^ value[w]);
+		while (empty) // the rare case
+		{
+			reset(base + highestbitset(empty & -empty));
+			empty &= empty - 1;
+		}
+	}
+}
+
+void prd_pool::roll_ids(const uint32_t* ids, int count, uint64_t* result)
+{
+	DICEY_SCOPE("prd_pool::roll_ids");
+	for (int i = 0; i < count; i++)
+	{
+		const uint32_t idx = ids[i];
+		const uint64_t bit = 1ull << (idx % 64);
+		if (roll(idx)) result[idx / 64] |= bit;
+		else result[idx / 64] &= ~bit;
+	}
+}
+
+std::vector<uint64_t> integer_prd::roll_n(uint64_t n)
+{
+	DICEY_SCOPE("integer_prd::roll_n");
+	std::vector<uint64_t> histogram(range, 0);
+	for (; n > 0 && remaining() != size(); n--) histogram[fastmod32(linear_series::roll(), magic, range)]++; // finish the current window
+	const uint64_t windows = n / size();
+	if (windows > 0)
+	{
+		const uint32_t whole = size() / range;
+		const uint32_t partial = size() % range;
+		for (uint32_t i = 0; i < range; i++) histogram[i] += windows * (whole + (i < partial));
+		skip(windows * size());
+		n -= windows * size();
+	}
+	for (; n > 0; n--) histogram[fastmod32(linear_series::roll(), magic, range)]++;
+	return histogram;
+}
+
+static unsigned weights_sum(const std::vector<int>& weights)
+{
+	assert(!weights.empty());
+	long sum = 0;
+	for (int w : weights) { assert(w >= 0); sum += w; }
+	assert(sum > 0 && sum <= INT32_MAX);
+	return sum;
+}
+
+weighted_bag::weighted_bag(const seed& orig, const std::vector<int>& weights) : series(orig, weights_sum(weights)), cumulative(weights.size())
+{
+	std::partial_sum(weights.begin(), weights.end(), cumulative.begin());
+}
+
+int weighted_bag::roll(luck_type rollee)
+{
+	const bool lucky = (rollee == luck_type::lucky || rollee == luck_type::very_lucky);
+	const bool unlucky = (rollee == luck_type::unlucky || rollee == luck_type::very_unlucky);
+	const int a = roll();
+	if (!lucky && !unlucky) return a;
+	const int b = lookup(series.roll());
+	const bool swap = lucky ? weight(b) < weight(a) : weight(b) > weight(a);
+	held = swap ? a : b;
+	return swap ? b : a;
+}
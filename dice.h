@@ -65,6 +65,27 @@ struct seed
 	uint64_t orig;
 };
 
+#ifdef DICEY_STATS
+#define DICEY_STAT(x) x
+#else
+#define DICEY_STAT(x)
+#endif
+
+/// Telemetry for a retry loop, such as the rerolls in `linear_series::roll()`. Only collected when compiled with DICEY_STATS defined, otherwise
+/// the structures below do not even have room for it. Watch 'max' and the top of the histogram to catch a badly configured table before it
+/// turns into a latency spike.
+struct rejection_stats
+{
+	uint64_t calls = 0; // calls that went into the loop
+	uint64_t attempts = 0; // attempts summed over all calls, including the successful one
+	uint64_t max = 0; // most attempts taken by a single call
+	uint64_t histogram[16] = {}; // calls by attempts, bucket i counts 2^i to 2^(i+1)-1 attempts, the last bucket also counts everything above
+
+	inline void record(uint64_t n) { calls++; attempts += n; max = std::max(max, n); histogram[std::min(highestbitset(n), 15)]++; }
+	inline double mean() const { return calls ? (double)attempts / calls : 0.0; }
+	inline void reset() { *this = rejection_stats(); }
+};
+
 struct roll_table
 {
 	seed s;
@@ -103,6 +124,17 @@ struct roll_table
 	/// Does a single roll on a roll table, modifying it by removing the entry hit. Returns -1 if table is empty. The next most rare entry in the roll table after the
 	/// the deleted entry gains its chance to be rolled (so we do not have to rewrite the table).
 	int boxgacha(luck_type rollee = luck_type::normal, int roll_weight = 0);
+
+#ifdef DICEY_STATS
+	struct table_stats
+	{
+		rejection_stats unique_rolls; // rolls needed per unique result
+		rejection_stats boxgacha; // table entries looked at to find one that is not yet taken
+	};
+	const table_stats& stats() const { return telemetry; }
+	void reset_stats() { telemetry = table_stats(); }
+	table_stats telemetry;
+#endif
 };
 
 struct const_roll_table
@@ -186,31 +218,57 @@ struct linear_roll_table
 /// might be accessible only after a call to reset().
 struct linear_series
 {
-	linear_series(const seed& orig, unsigned entries) : state(orig.state), cur(entries), unused(entries)
+	linear_series(const seed& orig, uint64_t entries) : state(orig.state), cur(entries), unused(entries)
 	{
-		assert(entries > 0);
+		assert(entries > 0 && entries < (1ull << 63));
 		if (ispow2(entries)) entries++;
-		len = next_pow2(entries);
+		len = next_pow2_64(entries);
 		bits = highestbitset(len);
 		tap = lfsr_tap(bits);
 		x = lfsr_init(orig.state, bits);
 	}
 
 	void reset() { state = splitmix64(state); x = lfsr_init(state, bits); unused = cur; }
-	uint32_t roll() { uint32_t ret; do { lfsr_next(x, tap); ret = x - 1; } while (ret >= cur); unused--; if (unused == 0) reset(); return ret; }
-	inline uint32_t size() const { return cur; }
-	inline uint32_t reserved() const { return len; }
-	inline uint32_t remaining() const { return unused; }
-
-	inline void restricted(uint32_t newsize)
+	uint64_t roll()
+	{
+		uint64_t ret;
+		DICEY_STAT(uint64_t tries = 0;)
+		do { lfsr_next(x, tap); ret = x - 1; DICEY_STAT(tries++;) } while (ret >= cur);
+		DICEY_STAT(rejections.record(tries);)
+		unused--; if (unused == 0) reset(); return ret;
+	}
+	/// Roll 'n' values into 'out'. Gives the same results and end state as calling roll() 'n' times, but steps eight interleaved LFSR lanes
+	/// at a time and compacts away rerolls without branching, so it is much faster when refilling large work queues. The 32 bit version
+	/// requires that the series has at most 2^32 entries. With DICEY_STATS, the batched path adds to the calls and attempts of stats(),
+	/// but not to its maximum or histogram, since it does not look at values one by one.
+	void roll_n(int n, uint32_t* out);
+	void roll_n(int n, uint64_t* out);
+	/// Skip ahead as if roll() was called 'n' times. Only the part within the last series is O(log n), and only when the size is one less
+	/// than a power of two so that there are no rerolls; for other sizes we step through it with roll(). Every whole series skipped still
+	/// costs one reseed, since the seed chain cannot be jumped, so skipping 'k' series is O(k) on top of that.
+	void skip(uint64_t n);
+	inline uint64_t size() const { return cur; }
+	inline uint64_t reserved() const { return len; }
+	inline uint64_t remaining() const { return unused; }
+
+	inline void restricted(uint64_t newsize)
 	{
 		assert(newsize > 0);
 		cur = std::min(len, newsize);
 	}
 
+#ifdef DICEY_STATS
+	/// LFSR steps needed per roll. Grows with how far the size is below the next power of two.
+	const rejection_stats& stats() const { return rejections; }
+	void reset_stats() { rejections.reset(); }
+#endif
+
 protected:
-	uint64_t state, x;
-	uint32_t tap, len, cur, unused, bits;
+	template<typename T> void roll_lanes(int n, T* out);
+
+	uint64_t state, x, tap, len, cur, unused;
+	uint32_t bits;
+	DICEY_STAT(rejection_stats rejections;)
 };
 
 /// Pseudo-random distribution across an integer range, allowing repeated values, but requiring a window size.
@@ -222,20 +280,80 @@ protected:
 class integer_prd : protected linear_series
 {
 public:
-	integer_prd(const seed& orig, int min, int max, int window) : linear_series(orig, window), min_val(min), max_val(max)
+	integer_prd(const seed& orig, int min, int max, int window) : linear_series(orig, window), min_val(min), max_val(max), range(max - min + 1), magic(fastmod32_magic(range))
 	{
 		assert(max >= min);
 		assert(window > 0);
 	}
-	int roll() { return min_val + (linear_series::roll() % (max_val - min_val + 1)); }
+	int roll() { return min_val + fastmod32(linear_series::roll(), magic, range); }
+	/// Roll 'n' times and return how many times each value from min to max came up. Leaves the same state as 'n' calls to roll(), but whole
+	/// windows are counted arithmetically, since each window rolls every value of the series exactly once. Skipping past them still costs
+	/// one reseed per window, see linear_series::skip(), so this is linear in n / size() with a small constant, and linear in what is left.
+	std::vector<uint64_t> roll_n(uint64_t n);
 
 	using linear_series::reset;
 	using linear_series::remaining;
 	using linear_series::size;
+#ifdef DICEY_STATS
+	using linear_series::stats;
+	using linear_series::reset_stats;
+#endif
 
 private:
 	int min_val;
 	int max_val;
+	uint32_t range;
+	uint64_t magic; // for the division free modulo of the range
+};
+
+/// The same as `integer_prd` above, but with the range given at compile time, so that the compiler can replace the modulo with a multiplication
+/// of its own choosing. Gives exactly the same results.
+template<int Min, int Max>
+class static_integer_prd : protected linear_series
+{
+	static_assert(Max >= Min);
+public:
+	static_integer_prd(const seed& orig, int window) : linear_series(orig, window) { assert(window > 0); }
+	int roll() { return Min + (linear_series::roll() % (uint32_t)(Max - Min + 1)); }
+
+	using linear_series::reset;
+	using linear_series::remaining;
+	using linear_series::size;
+#ifdef DICEY_STATS
+	using linear_series::stats;
+	using linear_series::reset_stats;
+#endif
+};
+
+/// A weighted shuffle bag, where every window of draws contains each entry exactly as many times as its weight, and the window size is the
+/// sum of all weights. It walks a `linear_series` permutation of the window and maps each position onto the cumulative weights, so the expanded
+/// deck is never stored. Memory use is O(1) in the window size, and each draw is O(log k) in the number of weights.
+class weighted_bag
+{
+public:
+	weighted_bag(const seed& orig, const std::vector<int>& weights);
+
+	/// Draw the next entry.
+	int roll() { if (held >= 0) { const int r = held; held = -1; return r; } return lookup(series.roll()); }
+	/// Draw with a luck bias. Lucky and very lucky draws return the rarer of the next two entries, and unlucky and very unlucky the more common one.
+	/// The other entry is held back for the next draw, so every entry still comes up exactly as often as its weight, but rare entries tend to come
+	/// earlier, or for unlucky draws up to a window later. The held back entry means a window can be off by one entry. Other luck types draw normally.
+	int roll(luck_type rollee);
+
+	inline uint32_t size() const { return series.size(); }
+	inline uint32_t remaining() const { return series.remaining(); }
+	inline int weight(int idx) const { return cumulative.at(idx) - (idx > 0 ? cumulative.at(idx - 1) : 0); }
+#ifdef DICEY_STATS
+	const rejection_stats& stats() const { return series.stats(); }
+	void reset_stats() { series.reset_stats(); }
+#endif
+
+private:
+	inline int lookup(uint32_t pos) const { return std::upper_bound(cumulative.begin(), cumulative.end(), (int)pos) - cumulative.begin(); }
+
+	linear_series series;
+	std::vector<int> cumulative; // running sum of the weights
+	int held = -1; // entry held back by a luck biased draw
 };
 
 /// Pseudo-random distribution (PRD) of a boolean chance, guaranteeing success no earlier than 50% before and no later than 50% after the average number of rolls. You use this if
@@ -250,6 +368,19 @@ enum class prd_function : uint8_t
 	/// A distribution where only the starting point is random, after that it is only a matter of counting. When a good distribution is more important than not being able to predict or game it.
 	predictable,
 };
+/// The reset step shared by the `prd` family. Draws the number of rolls until the next success and returns it as the new accumulator.
+static inline uint16_t prd_reset(uint64_t& state, uint16_t chance, int16_t& remainder, prd_function func)
+{
+	if (func == prd_function::predictable) return 1000 / std::max<int>(chance, 1) - 1;
+	const int max = (1000 / std::max<int>(chance, 1)) - 1;
+	const int incr = (func == prd_function::fair) ? (max >> 1) : 0;
+	const int high = max + remainder + incr - 1;
+	const int low = incr + remainder;
+	const uint16_t accum = fastrange(xorshift64(state), low, high) + 1;
+	remainder = max - ((int)accum) + remainder;
+	return accum;
+}
+
 struct prd
 {
 	prd() = delete;
@@ -263,16 +394,23 @@ struct prd
 	inline bool roll() { if (accum) { accum--; return !value; } else { reset(); return value; } }
 	/// A roll that accepts luck types normal, lucky and very lucky (and only those).
 	bool roll(luck_type rollee) { if (rollee == luck_type::very_lucky && accum) accum--; if ((rollee == luck_type::lucky || rollee == luck_type::very_lucky) && accum) accum--; return roll(); }
-	void reset()
+	/// Roll 'n' times and return the number of successes, for example to catch up after a long idle time. Leaves the same state as 'n' calls
+	/// to roll(), but jumps straight from one reset to the next, so it only does work once per reset. For the predictable function it is O(1).
+	uint64_t roll_n(uint64_t n)
 	{
-		if (func == prd_function::predictable) { accum = 1000 / std::max<int>(chance, 1) - 1; return; }
-		const int max = (1000 / std::max<int>(chance, 1)) - 1;
-		const int incr = (func == prd_function::fair) ? (max >> 1) : 0;
-		const int high = max + remainder + incr - 1;
-		const int low = incr + remainder;
-		accum = fastrange(xorshift64(state), low, high) + 1;
-		remainder = max - ((int)accum) + remainder;
+		const uint64_t total = n;
+		uint64_t resets = 0;
+		while (n > accum)
+		{
+			n -= (uint64_t)accum + 1;
+			reset();
+			resets++;
+			if (func == prd_function::predictable) { resets += n / ((uint64_t)accum + 1); n %= (uint64_t)accum + 1; } // every period is the same
+		}
+		accum -= n;
+		return value ? resets : total - resets;
 	}
+	void reset() { accum = prd_reset(state, chance, remainder, func); }
 	// We maintain a total of 128 bits, or 16 bytes, of data.
 	uint64_t state;
 	uint16_t chance;
@@ -282,6 +420,68 @@ struct prd
 	prd_function func; // 8bit
 };
 
+/// A compact 8 byte version of `prd` for when you need a great many of them, for example a pity counter per player and item type. Instead of
+/// storing its own generator state, it derives the randomness for each reset from a shared parent seed, an entity id and a count of its
+/// resets so far, so it stays deterministic. You must pass the same parent and id every time. The reset count wraps after 65536 resets.
+struct compact_prd
+{
+	compact_prd() = delete;
+	compact_prd(const seed& parent, uint64_t id, uint16_t probability, prd_function _func = prd_function::fair)
+	  : chance(probability < 500 ? probability : 1000 - probability), value(probability < 500 ? true : false), func((uint16_t)_func)
+	{
+		if (function() == prd_function::predictable) { uint64_t state = parent.derive(id, resets++).state; accum = fastrange(xorshift64(state), 0, 1000 / std::max<int>(chance, 1) - 1); }
+		else reset(parent, id);
+	}
+	inline bool roll(const seed& parent, uint64_t id) { if (accum) { accum--; return !value; } else { reset(parent, id); return value; } }
+	/// A roll that accepts luck types normal, lucky and very lucky (and only those).
+	bool roll(const seed& parent, uint64_t id, luck_type rollee) { if (rollee == luck_type::very_lucky && accum) accum--; if ((rollee == luck_type::lucky || rollee == luck_type::very_lucky) && accum) accum--; return roll(parent, id); }
+	void reset(const seed& parent, uint64_t id) { uint64_t state = parent.derive(id, resets++).state; accum = prd_reset(state, chance, remainder, function()); }
+	inline prd_function function() const { return (prd_function)func; }
+
+	uint16_t accum = 0;
+	int16_t remainder = 0;
+	uint16_t resets = 0;
+	uint16_t chance : 10; // at most 500
+	uint16_t value : 1;
+	uint16_t func : 2;
+};
+static_assert(sizeof(compact_prd) == 8);
+
+/// Many `prd` objects kept as a structure of arrays, for when you have millions of them and roll large subsets at once. Rolling a subset
+/// counts down all the accumulators in one vectorizable pass and only takes the scalar path for the few entries that need a reset. Every
+/// entry gives exactly the same results as a `prd` constructed with the same arguments. All entries share the same `prd_function`.
+struct prd_pool
+{
+	explicit prd_pool(prd_function _func = prd_function::fair) : func(_func) {}
+
+	/// Add an entry, initialized just like `prd(orig, probability, func)`. Returns its index.
+	uint32_t add(const seed& orig, uint16_t probability);
+	inline uint32_t size() const { return state.size(); }
+	/// Number of 64 bit words needed for the bitsets below.
+	inline uint32_t words() const { return (size() + 63) / 64; }
+
+	/// Roll a single entry.
+	inline bool roll(uint32_t idx)
+	{
+		const bool v = (value[idx / 64] >> (idx % 64)) & 1;
+		if (accum[idx]) { accum[idx]--; return !v; } else { reset(idx); return v; }
+	}
+	/// Roll every entry that has its bit set in 'mask', and store its result in the same bit of 'result'. Both must hold words() entries.
+	/// Bits not in the mask, and those past the last entry, are cleared.
+	void roll_masked(const uint64_t* mask, uint64_t* result);
+	/// Roll the listed entries in order, setting or clearing their bits in 'result', which must hold words() entries.
+	void roll_ids(const uint32_t* ids, int count, uint64_t* result);
+
+	inline void reset(uint32_t idx) { accum[idx] = prd_reset(state[idx], chance[idx], remainder[idx], func); }
+
+	std::vector<uint64_t> state;
+	std::vector<uint16_t> accum;
+	std::vector<int16_t> remainder;
+	std::vector<uint16_t> chance;
+	std::vector<uint64_t> value; // bitset of the result given on reset, see `prd`
+	prd_function func;
+};
+
 /// Merge two opposed luck types together, eg where you have a luck to hit and enemy has a luck not to be hit
 luck_type luck_combine(luck_type rollee, luck_type against);
 
@@ -0,0 +1,62 @@
+#include "direction.h"
+#include "dmath.h"
+
+template<isin_method M> static inline __attribute__((always_inline)) int32_t isin_any(direction d)
+{
+	if constexpr (M == isin_method::table) return isin_lerp(d);
+	else return isin(d);
+}
+
+// The kernel loops. Always inlined, so that each instruction set level gets its own copy. The table lookups become gathers at the
+// levels that have them.
+
+template<isin_method M> static inline __attribute__((always_inline)) void isin_n_body(const direction* __restrict in, int32_t* __restrict out, uint16_t offset, size_t n)
+{
+	for (size_t i = 0; i < n; i++) out[i] = isin_any<M>((direction)(in[i] + offset));
+}
+
+template<isin_method M> static inline __attribute__((always_inline)) void sincos_n_body(const direction* __restrict in, int32_t* __restrict sin_out, int32_t* __restrict cos_out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		sin_out[i] = isin_any<M>(in[i]);
+		cos_out[i] = isin_any<M>((direction)(in[i] + 16384U));
+	}
+}
+
+namespace
+{
+	struct direction_kernels
+	{
+		void (*isin_n[2])(const direction* in, int32_t* out, uint16_t offset, size_t n);
+		void (*sincos_n[2])(const direction* in, int32_t* sin_out, int32_t* cos_out, size_t n);
+	};
+}
+
+#define DICEY_DIRECTION_KERNELS(level, attr) \
+	attr static void isin_poly_##level(const direction* in, int32_t* out, uint16_t offset, size_t n) { isin_n_body<isin_method::polynomial>(in, out, offset, n); } \
+	attr static void isin_table_##level(const direction* in, int32_t* out, uint16_t offset, size_t n) { isin_n_body<isin_method::table>(in, out, offset, n); } \
+	attr static void sincos_poly_##level(const direction* in, int32_t* sin_out, int32_t* cos_out, size_t n) { sincos_n_body<isin_method::polynomial>(in, sin_out, cos_out, n); } \
+	attr static void sincos_table_##level(const direction* in, int32_t* sin_out, int32_t* cos_out, size_t n) { sincos_n_body<isin_method::table>(in, sin_out, cos_out, n); } \
+	static const direction_kernels kernels_##level = { { isin_poly_##level, isin_table_##level }, { sincos_poly_##level, sincos_table_##level } };
+
+DICEY_DIRECTION_KERNELS(scalar, )
+#if defined(__x86_64__) && defined(__GNUC__)
+DICEY_DIRECTION_KERNELS(sse42, DICEY_SSE42)
+DICEY_DIRECTION_KERNELS(avx2, DICEY_AVX2)
+DICEY_DIRECTION_KERNELS(avx512, DICEY_AVX512)
+static const direction_kernels* const kernel_table[] = { &kernels_scalar, &kernels_sse42, &kernels_avx2, &kernels_avx512 };
+#else
+static const direction_kernels* const kernel_table[] = { &kernels_scalar, &kernels_scalar, &kernels_scalar, &kernels_scalar };
+#endif
+
+template<isin_method M> void isin_n(const direction* in, int32_t* out, size_t n) { kernel_table[(int)cpu_level_active()]->isin_n[(int)M](in, out, 0, n); }
+template<isin_method M> void icos_n(const direction* in, int32_t* out, size_t n) { kernel_table[(int)cpu_level_active()]->isin_n[(int)M](in, out, 16384, n); }
+template<isin_method M> void sincos_n(const direction* in, int32_t* sin_out, int32_t* cos_out, size_t n) { kernel_table[(int)cpu_level_active()]->sincos_n[(int)M](in, sin_out, cos_out, n); }
+
+template void isin_n<isin_method::polynomial>(const direction*, int32_t*, size_t);
+template void isin_n<isin_method::table>(const direction*, int32_t*, size_t);
+template void icos_n<isin_method::polynomial>(const direction*, int32_t*, size_t);
+template void icos_n<isin_method::table>(const direction*, int32_t*, size_t);
+template void sincos_n<isin_method::polynomial>(const direction*, int32_t*, int32_t*, size_t);
+template void sincos_n<isin_method::table>(const direction*, int32_t*, int32_t*, size_t);
@@ -2,7 +2,9 @@
 
 // Fast and deterministic direction math
 
+#include <array>
 #include <cmath>
+#include <stddef.h>
 #include <stdint.h>
 
 // -- Types --
@@ -23,8 +25,53 @@ static inline int32_t isin(direction val)
 /// Cosine with degrees represented as the full range of unsigned 16 bit.
 static inline int32_t icos(direction val) { return isin(val + 16384U); }
 
+/// Sine of a quarter turn in 1024 steps, in Q16 and rounded. The low 17 bits of each entry are the sine at the start of its step, and the
+/// bits above them how much it grows until the next one, so that interpolating between them takes a single lookup. Made at compile time
+/// from a Taylor series.
+inline constexpr std::array<uint32_t, 1024> isin_quadrant_table = []
+{
+	int32_t exact[1025] {};
+	for (int i = 0; i <= 1024; i++)
+	{
+		const double x = i * (3.14159265358979323846 / 2048.0);
+		double term = x, sum = x;
+		for (int k = 1; k < 16; k++) { term *= -x * x / ((2 * k) * (2 * k + 1)); sum += term; }
+		exact[i] = (int32_t)(sum * 65536.0 + 0.5);
+	}
+	std::array<uint32_t, 1024> table {};
+	for (int i = 0; i < 1024; i++) table[i] = (uint32_t)exact[i] | (uint32_t)(exact[i + 1] - exact[i]) << 17;
+	return table;
+}();
+
+/// Sine like isin(), but looked up in isin_quadrant_table with linear interpolation. It is rounded only once from the table's more
+/// exact values, so it is within one of the exact sine, while isin() can be off by two. The two differ by at most two.
+static inline int32_t isin_lerp(direction val)
+{
+	const uint32_t q = val >> 14;
+	const uint32_t i = (q & 1) ? 16384 - (val & 0x3FFF) : (val & 0x3FFF); // angle into the quadrant, from 0 to 16384
+	const uint32_t index = (i - (i >> 14)) >> 4; // so that a full quarter turn is the end of the last step, not past the table
+	const uint32_t frac = i - index * 16;
+	const uint32_t entry = isin_quadrant_table[index];
+	const int32_t y = ((entry & 0x1FFFF) * 16 + (entry >> 17) * frac + 128) >> 8;
+	return (q & 2) ? -y : y;
+}
+
+/// Cosine like icos(), from the table.
+static inline int32_t icos_lerp(direction val) { return isin_lerp(val + 16384U); }
+
 /// Snap direction to nearest axis-aligned direction
 static inline direction snap(direction dir) { return (dir + 0x2000) & 0xC000; }
 
 static inline int isinr(direction dir, int dist) { return ((int64_t)dist * isin(dir)) / 65536; }
 static inline int icosr(direction dir, int dist) { return ((int64_t)dist * icos(dir)) / 65536; }
+
+// -- Array versions --
+
+/// Which sine the array versions below use: the polynomial of isin(), or the table of isin_lerp().
+enum class isin_method { polynomial, table };
+
+/// isin(), icos() or both of 'n' directions, or the table versions of them. Built for each instruction set level and picked at runtime
+/// like the bulk kernels in dmath.h. Every level gives the same results as the scalar functions.
+template<isin_method M = isin_method::polynomial> void isin_n(const direction* in, int32_t* out, size_t n);
+template<isin_method M = isin_method::polynomial> void icos_n(const direction* in, int32_t* out, size_t n);
+template<isin_method M = isin_method::polynomial> void sincos_n(const direction* in, int32_t* sin_out, int32_t* cos_out, size_t n);
@@ -1,43 +1,298 @@
 #include "dmath.h"
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
-// Magic numbers from https://users.ece.cmu.edu/~koopman/lfsr/
-uint32_t lfsr_tap(uint32_t size)
-{
-	switch (size)
-	{
-	case 2: return 0x3;
-	case 3: return 0x6;
-	case 4: return 0xC;
-	case 5: return 0x14;
-	case 6: return 0x30;
-	case 7: return 0x60;
-	case 8: return 0xB4;
-	case 9: return 0x110;
-	case 10: return 0x240;
-	case 11: return 0x500;
-	case 12: return 0xE08;
-	case 13: return 0x1C80;
-	case 14: return 0x3802;
-	case 15: return 0x6000;
-	case 16: return 0xB400;
-	case 17: return 0x10004;
-	case 18: return 0x20013;
-	case 19: return 0x40013;
-	case 20: return 0x80004;
-	case 21: return 0x100002;
-	case 22: return 0x200001;
-	case 23: return 0x400010;
-	case 24: return 0x80000D;
-	case 25: return 0x1000004;
-	case 26: return 0x2000023;
-	case 27: return 0x4000013;
-	case 28: return 0x8000004;
-	case 29: return 0x10000002;
-	case 30: return 0x20000029;
-	case 31: return 0x40000004;
-	case 32: return 0x80000057;
-	default: assert(false); break;
-	}
-	return 0;
+// Multiply a GF(2) bit matrix, stored as one column per input bit, with a bit vector.
+static inline uint64_t gf2_apply(const uint64_t* m, uint64_t v)
+{
+	uint64_t r = 0;
+	for (int i = 0; v; i++, v >>= 1) if (v & 1) r ^= m[i];
+	return r;
+}
+
+uint64_t lfsr_skip(uint64_t state, uint64_t tap, uint32_t bits, uint64_t steps)
+{
+	assert(bits > 0 && bits <= 64);
+	steps %= (bits < 64) ? (1ull << bits) - 1 : UINT64_MAX; // period of a maximal length LFSR
+	uint64_t m[64];
+	uint64_t t[64];
+	for (uint32_t i = 0; i < bits; i++) { m[i] = 1ull << i; lfsr_next(m[i], tap); }
+	while (steps)
+	{
+		if (steps & 1) state = gf2_apply(m, state);
+		steps >>= 1;
+		if (!steps) break;
+		for (uint32_t i = 0; i < bits; i++) t[i] = gf2_apply(m, m[i]);
+		std::copy_n(t, bits, m);
+	}
+	return state;
+}
+
+void lfsr_stride_table(uint64_t tap, uint64_t* table)
+{
+	// Bits above the lowest eight never reach the feedback within eight steps, so they just shift down, and
+	// by linearity the rest is the XOR of the eight single bit columns.
+	uint64_t col[8];
+	for (int i = 0; i < 8; i++) { col[i] = 1ull << i; for (int j = 0; j < 8; j++) lfsr_next(col[i], tap); }
+	table[0] = 0;
+	for (int v = 1; v < 256; v++) table[v] = table[v & (v - 1)] ^ col[highestbitset(v & -v)];
+}
+
+// -- Bulk kernels --
+
+// Each kernel body is written once, and then compiled for every instruction set level with the target attribute below, so that the
+// compiler can vectorize it for that level. Every lane runs the full number of steps so that the loops vectorize.
+static inline __attribute__((always_inline)) void isqrt_n_body(const uint64_t* in, uint64_t* out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		uint64_t x = in[i];
+		uint64_t r = 0;
+		#pragma GCC unroll 32
+		for (int s = 31; s >= 0; s--)
+		{
+			const uint64_t bit = 1ull << (2 * s);
+			const uint64_t t = r + bit;
+			const uint64_t m = -(uint64_t)(x >= t);
+			x -= t & m;
+			r = (r >> 1) + (bit & m);
+		}
+		out[i] = r;
+	}
+}
+
+static inline __attribute__((always_inline)) void isqrt32_n_body(const uint32_t* in, uint32_t* out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		uint32_t x = in[i];
+		uint32_t r = 0;
+		#pragma GCC unroll 16
+		for (int s = 15; s >= 0; s--)
+		{
+			const uint32_t bit = 1u << (2 * s);
+			const uint32_t t = r + bit;
+			const uint32_t m = -(uint32_t)(x >= t);
+			x -= t & m;
+			r = (r >> 1) + (bit & m);
+		}
+		out[i] = r;
+	}
+}
+
+static inline __attribute__((always_inline)) void xorshift64_n_body(uint64_t* state, size_t n)
+{
+	for (size_t i = 0; i < n; i++) xorshift64(state[i]);
+}
+
+static void fastrange_n_generic(const uint64_t* in, uint64_t low, uint64_t high, uint64_t* out, size_t n)
+{
+	for (size_t i = 0; i < n; i++) out[i] = fastrange(in[i], low, high);
+}
+
+static void splitmix64_n_generic(const uint64_t* in, uint64_t* out, size_t n)
+{
+	for (size_t i = 0; i < n; i++) out[i] = splitmix64(in[i]);
+}
+
+struct dmath_kernels
+{
+	void (*isqrt_n)(const uint64_t* in, uint64_t* out, size_t n);
+	void (*isqrt32_n)(const uint32_t* in, uint32_t* out, size_t n);
+	void (*xorshift64_n)(uint64_t* state, size_t n);
+	void (*fastrange_n)(const uint64_t* in, uint64_t low, uint64_t high, uint64_t* out, size_t n);
+	void (*splitmix64_n)(const uint64_t* in, uint64_t* out, size_t n);
+};
+
+#define DICEY_KERNELS(level, attr, fastrange_n, splitmix64_n) \
+	attr static void isqrt_n_##level(const uint64_t* in, uint64_t* out, size_t n) { isqrt_n_body(in, out, n); } \
+	attr static void isqrt32_n_##level(const uint32_t* in, uint32_t* out, size_t n) { isqrt32_n_body(in, out, n); } \
+	attr static void xorshift64_n_##level(uint64_t* state, size_t n) { xorshift64_n_body(state, n); } \
+	static const dmath_kernels kernels_##level = { isqrt_n_##level, isqrt32_n_##level, xorshift64_n_##level, fastrange_n, splitmix64_n };
+
+// The scalar level is whatever the build flags give us.
+DICEY_KERNELS(scalar, , fastrange_n_generic, splitmix64_n_generic)
+#if defined(__x86_64__) && defined(__GNUC__)
+#define DICEY_X86 1
+#include <immintrin.h>
+
+// Compilers do not vectorize 64 bit multiplies on their own, since AVX2 has no such instruction. We build them out of 32x32->64 bit
+// partial products instead. 'b' is the same in every lane; vpmuludq only looks at the low half of each lane, so 'b' is also its low half.
+DICEY_AVX2 static inline __m256i mulhi64_avx2(__m256i a, __m256i b, __m256i b_hi)
+{
+	const __m256i a_hi = _mm256_srli_epi64(a, 32);
+	const __m256i lo_lo = _mm256_mul_epu32(a, b);
+	const __m256i hi_lo = _mm256_mul_epu32(a_hi, b);
+	const __m256i lo_hi = _mm256_mul_epu32(a, b_hi);
+	const __m256i hi_hi = _mm256_mul_epu32(a_hi, b_hi);
+	const __m256i t = _mm256_add_epi64(hi_lo, _mm256_srli_epi64(lo_lo, 32));
+	const __m256i w = _mm256_add_epi64(_mm256_and_si256(t, _mm256_set1_epi64x(0xffffffff)), lo_hi);
+	return _mm256_add_epi64(_mm256_add_epi64(hi_hi, _mm256_srli_epi64(t, 32)), _mm256_srli_epi64(w, 32));
+}
+
+DICEY_AVX2 static inline __m256i mullo64_avx2(__m256i a, __m256i b, __m256i b_hi)
+{
+	const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, b_hi));
+	return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+}
+
+DICEY_AVX2 static void fastrange_n_avx2(const uint64_t* in, uint64_t low, uint64_t high, uint64_t* out, size_t n)
+{
+	assert(low <= high);
+	assert(high != UINT64_MAX);
+	const uint64_t range = high + 1 - low;
+	const __m256i b = _mm256_set1_epi64x(range);
+	const __m256i b_hi = _mm256_set1_epi64x(range >> 32);
+	const __m256i l = _mm256_set1_epi64x(low);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m256i a = _mm256_loadu_si256((const __m256i*)(in + i));
+		_mm256_storeu_si256((__m256i*)(out + i), _mm256_add_epi64(mulhi64_avx2(a, b, b_hi), l));
+	}
+	for (; i < n; i++) out[i] = fastrange(in[i], low, high);
+}
+
+DICEY_AVX2 static void splitmix64_n_avx2(const uint64_t* in, uint64_t* out, size_t n)
+{
+	const __m256i c1 = _mm256_set1_epi64x(0xbf58476d1ce4e5b9);
+	const __m256i c1_hi = _mm256_set1_epi64x(0xbf58476d1ce4e5b9 >> 32);
+	const __m256i c2 = _mm256_set1_epi64x(0x94d049bb133111eb);
+	const __m256i c2_hi = _mm256_set1_epi64x(0x94d049bb133111eb >> 32);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256i z = _mm256_add_epi64(_mm256_loadu_si256((const __m256i*)(in + i)), _mm256_set1_epi64x(0x9e3779b97f4a7c15));
+		z = mullo64_avx2(_mm256_xor_si256(z, _mm256_srli_epi64(z, 30)), c1, c1_hi);
+		z = mullo64_avx2(_mm256_xor_si256(z, _mm256_srli_epi64(z, 27)), c2, c2_hi);
+		_mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(z, _mm256_srli_epi64(z, 31)));
+	}
+	for (; i < n; i++) out[i] = splitmix64(in[i]);
+}
+
+// AVX-512 has a 64 bit low multiply (vpmullq), but still no high one. GCC 12 warns about _mm512_undefined_epi32() in its own headers,
+// as maybe used uninitialized when optimizing and as used uninitialized when not.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+DICEY_AVX512 static inline __m512i mulhi64_avx512(__m512i a, __m512i b, __m512i b_hi)
+{
+	const __m512i a_hi = _mm512_srli_epi64(a, 32);
+	const __m512i lo_lo = _mm512_mul_epu32(a, b);
+	const __m512i hi_lo = _mm512_mul_epu32(a_hi, b);
+	const __m512i lo_hi = _mm512_mul_epu32(a, b_hi);
+	const __m512i hi_hi = _mm512_mul_epu32(a_hi, b_hi);
+	const __m512i t = _mm512_add_epi64(hi_lo, _mm512_srli_epi64(lo_lo, 32));
+	const __m512i w = _mm512_add_epi64(_mm512_and_si512(t, _mm512_set1_epi64(0xffffffff)), lo_hi);
+	return _mm512_add_epi64(_mm512_add_epi64(hi_hi, _mm512_srli_epi64(t, 32)), _mm512_srli_epi64(w, 32));
+}
+
+DICEY_AVX512 static void fastrange_n_avx512(const uint64_t* in, uint64_t low, uint64_t high, uint64_t* out, size_t n)
+{
+	assert(low <= high);
+	assert(high != UINT64_MAX);
+	const uint64_t range = high + 1 - low;
+	const __m512i b = _mm512_set1_epi64(range);
+	const __m512i b_hi = _mm512_set1_epi64(range >> 32);
+	const __m512i l = _mm512_set1_epi64(low);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m512i a = _mm512_loadu_si512(in + i);
+		_mm512_storeu_si512(out + i, _mm512_add_epi64(mulhi64_avx512(a, b, b_hi), l));
+	}
+	if (i < n) // masked tail
+	{
+		const __mmask8 m = (1u << (n - i)) - 1;
+		const __m512i a = _mm512_maskz_loadu_epi64(m, in + i);
+		_mm512_mask_storeu_epi64(out + i, m, _mm512_add_epi64(mulhi64_avx512(a, b, b_hi), l));
+	}
+}
+
+DICEY_AVX512 static inline __m512i splitmix64_avx512(__m512i z)
+{
+	z = _mm512_add_epi64(z, _mm512_set1_epi64(0x9e3779b97f4a7c15));
+	z = _mm512_mullo_epi64(_mm512_xor_si512(z, _mm512_srli_epi64(z, 30)), _mm512_set1_epi64(0xbf58476d1ce4e5b9));
+	z = _mm512_mullo_epi64(_mm512_xor_si512(z, _mm512_srli_epi64(z, 27)), _mm512_set1_epi64(0x94d049bb133111eb));
+	return _mm512_xor_si512(z, _mm512_srli_epi64(z, 31));
+}
+
+DICEY_AVX512 static void splitmix64_n_avx512(const uint64_t* in, uint64_t* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) _mm512_storeu_si512(out + i, splitmix64_avx512(_mm512_loadu_si512(in + i)));
+	if (i < n)
+	{
+		const __mmask8 m = (1u << (n - i)) - 1;
+		_mm512_mask_storeu_epi64(out + i, m, splitmix64_avx512(_mm512_maskz_loadu_epi64(m, in + i)));
+	}
+}
+
+#pragma GCC diagnostic pop
+
+DICEY_KERNELS(sse42, DICEY_SSE42, fastrange_n_generic, splitmix64_n_generic)
+DICEY_KERNELS(avx2, DICEY_AVX2, fastrange_n_avx2, splitmix64_n_avx2)
+DICEY_KERNELS(avx512, DICEY_AVX512, fastrange_n_avx512, splitmix64_n_avx512)
+static const dmath_kernels* const kernel_table[] = { &kernels_scalar, &kernels_sse42, &kernels_avx2, &kernels_avx512 };
+#else
+static const dmath_kernels* const kernel_table[] = { &kernels_scalar, &kernels_scalar, &kernels_scalar, &kernels_scalar };
+#endif
+
+static const char* const cpu_level_names[] = { "scalar", "sse42", "avx2", "avx512" };
+
+const char* cpu_level_name(cpu_level level)
+{
+	return cpu_level_names[(int)level];
+}
+
+cpu_level cpu_level_detect()
+{
+#ifdef DICEY_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw")) return cpu_level::avx512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")) return cpu_level::avx2;
+	if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) return cpu_level::sse42;
+#endif
+	return cpu_level::scalar;
+}
+
+static cpu_level cpu_level_initial()
+{
+	cpu_level level = cpu_level_detect();
+	const char* env = getenv("DICEY_CPU_LEVEL");
+	if (env) for (int i = 0; i <= (int)level; i++) if (strcmp(env, cpu_level_names[i]) == 0) return (cpu_level)i;
+	return level;
 }
+
+// Picked on first use rather than during static initialization, so that kernels can be called from other static initializers.
+static cpu_level& active_level()
+{
+	static cpu_level level = cpu_level_initial();
+	return level;
+}
+
+static const dmath_kernels*& active_kernels()
+{
+	static const dmath_kernels* kernels = kernel_table[(int)active_level()];
+	return kernels;
+}
+
+cpu_level cpu_level_active()
+{
+	return active_level();
+}
+
+cpu_level cpu_level_set(cpu_level level)
+{
+	level = std::min(level, cpu_level_detect());
+	active_level() = level;
+	active_kernels() = kernel_table[(int)level];
+	return level;
+}
+
+void isqrt_n(const uint64_t* in, uint64_t* out, size_t n) { active_kernels()->isqrt_n(in, out, n); }
+void isqrt32_n(const uint32_t* in, uint32_t* out, size_t n) { active_kernels()->isqrt32_n(in, out, n); }
+void xorshift64_n(uint64_t* state, size_t n) { active_kernels()->xorshift64_n(state, n); }
+void fastrange_n(const uint64_t* in, uint64_t low, uint64_t high, uint64_t* out, size_t n) { active_kernels()->fastrange_n(in, low, high, out, n); }
+void splitmix64_n(const uint64_t* in, uint64_t* out, size_t n) { active_kernels()->splitmix64_n(in, out, n); }
@@ -5,9 +5,13 @@
 #include <cmath>
 #include <algorithm>
 #include <stdint.h>
+#include <stddef.h>
 #include <time.h>
 #include <array>
 #include <cassert>
+#include <type_traits>
+
+#include "instrument.h"
 
 // -- Constants --
 
@@ -27,11 +31,66 @@ __attribute__((const)) static inline constexpr int highestbitset(uint64_t v) { r
 __attribute__((const)) static inline constexpr int highestbitset(uint64_t v) { uint64_t r = 0; while (v >>= 1) r++; return r; }
 #endif
 
-/// See https://codereview.stackexchange.com/questions/69069/computing-the-square-root-of-a-64-bit-integer
-__attribute__((const)) static inline constexpr uint64_t isqrt(uint64_t x) { uint64_t r = (uint64_t)sqrt(x); r = std::min(r, (uint64_t)UINT32_MAX); while (r * r > x) r--; while (x - r * r > r * 2) r++; return r; }
+/// Seed for the reciprocal square root iterations below: 1/sqrt(i/256) in Q16 for i in [256, 1024), rounded.
+inline constexpr std::array<uint16_t, 768> isqrt_seed = []
+{
+	std::array<uint16_t, 768> table {};
+	for (uint64_t i = 256; i < 1024; i++)
+	{
+		uint64_t q = ((1ull << 40) + i / 2) / i;
+		uint64_t r = 0;
+		for (uint64_t bit = 1ull << 32; bit; bit >>= 2) // digit by digit, like isqrt_n()
+		{
+			const uint64_t t = r + bit;
+			const uint64_t m = -(uint64_t)(q >= t);
+			r = (r >> 1) + (bit & m);
+			q -= t & m;
+		}
+		table[i - 256] = std::min<uint64_t>(r + (q > r), UINT16_MAX);
+	}
+	return table;
+}();
+
+/// Integer square root of a 32 bit value, rounded down. Uses only integer math, so the result is the same everywhere. Normalizes
+/// the value with clz, seeds 1/sqrt from a table, does one Newton step and then fixes up the last bit.
+__attribute__((const)) static inline constexpr uint32_t isqrt32(uint32_t x)
+{
+	const int e = highestbitset(x) >> 1;
+	const uint64_t m = (uint64_t)(x | 1) << (30 - 2 * e); // in [2^30, 2^32), Q30
+	uint64_t y = (uint64_t)isqrt_seed[(m >> 22) - 256] << 15; // Q31
+	if (x >= 1u << 20) // the seed alone is good enough for results below 2^10
+	{
+		const uint64_t ayy = (m * ((y * y) >> 32)) >> 30;
+		y = (y * ((3ull << 30) - ayy)) >> 31;
+	}
+	uint64_t r = (m * y) >> (61 - e);
+	r -= r * r > x;
+	r += x - r * r > 2 * r;
+	return r;
+}
 
-/// For 32bits we have enough precision
-__attribute__((const)) static inline constexpr uint32_t isqrt32(uint32_t x) { return sqrt((double)x); }
+/// One Newton step for 1/sqrt(m) with m in Q62 and y in Q63
+__attribute__((const)) static inline constexpr uint64_t rsqrt_step_q62(uint64_t m, uint64_t y)
+{
+	const uint64_t yy = ((__uint128_t)y * y) >> 64;
+	const uint64_t ayy = ((__uint128_t)m * yy) >> 62;
+	return ((__uint128_t)y * ((3ull << 62) - ayy)) >> 63;
+}
+
+/// Integer square root, rounded down. As above, but two Newton steps for values of 2^32 and up.
+__attribute__((const)) static inline constexpr uint64_t isqrt(uint64_t x)
+{
+	if (x <= UINT32_MAX) return isqrt32(x);
+	const int e = highestbitset(x) >> 1;
+	const uint64_t m = x << (62 - 2 * e);
+	uint64_t y = (uint64_t)isqrt_seed[(m >> 54) - 256] << 47;
+	y = rsqrt_step_q62(m, y);
+	y = rsqrt_step_q62(m, y);
+	uint64_t r = std::min<uint64_t>(((__uint128_t)m * y) >> (125 - e), UINT32_MAX);
+	r -= r * r > x;
+	r += x - r * r > 2 * r;
+	return r;
+}
 
 /// See http://lemire.me/blog/2016/06/27/a-fast-alternative-to-the-modulo-reduction for an explanation of the snap to range magic.
 __attribute__((const)) static inline constexpr uint64_t fastrange(uint64_t state, uint64_t low, uint64_t high)
@@ -41,11 +100,23 @@ __attribute__((const)) static inline constexpr uint64_t fastrange(uint64_t state
 	return (uint64_t)(((__uint128_t)state * (__uint128_t)(high + 1 - low)) >> 64) + low;
 }
 
+/// Precompute the constant for fastmod32() below. See https://lemire.me/blog/2019/02/08/faster-remainder-by-direct-computation-applications-to-compilers-and-software-libraries/
+__attribute__((const)) static inline constexpr uint64_t fastmod32_magic(uint32_t d) { assert(d > 0); return UINT64_C(0xFFFFFFFFFFFFFFFF) / d + 1; }
+
+/// Division free 'a % d' for any 32 bit unsigned values, using the 'magic' constant from fastmod32_magic(d).
+__attribute__((const)) static inline constexpr uint32_t fastmod32(uint32_t a, uint64_t magic, uint32_t d) { return ((__uint128_t)(magic * a) * d) >> 64; }
+
 /// Fast check if an unsigned number is a power of two
 __attribute__((const)) static inline constexpr bool ispow2(uint64_t x) { return x && !(x & (x - 1)); }
 
 /// Your basic xorshift PRNG. State must be non-zero.
-static inline constexpr uint64_t xorshift64(uint64_t& state) { uint64_t x = state; x ^= x << 13; x ^= x >> 7; x ^= x << 17; return state = x; }
+static inline constexpr uint64_t xorshift64(uint64_t& state)
+{
+#ifdef DICEY_INSTRUMENT
+	if (!std::is_constant_evaluated()) DICEY_COUNT_DRAW();
+#endif
+	uint64_t x = state; x ^= x << 13; x ^= x >> 7; x ^= x << 17; return state = x;
+}
 
 /// Generic xorshift for any bitlength, assuming you have the right values to put into the equation. State must be non-zero.
 static inline constexpr uint32_t xorshift_args(uint64_t& x, uint32_t a, uint32_t b, uint32_t c, uint32_t d, uint32_t e, uint32_t f) { x |= (x == 0); x ^= (x & a) << b; x ^= x >> c; x ^= (x & d) << e; return x & f; }
@@ -68,17 +139,97 @@ __attribute__((const)) static inline uint32_t next_pow2(uint32_t x) { assert(x >
 __attribute__((const)) static inline uint32_t next_pow2(uint32_t v) { assert(v > 0); v; v--; v |= v >> 1; v |= v >> 2; v |= v >> 4; v |= v >> 8; v |= v >> 16; v++; return v; }
 #endif
 
+/// The same for 64 bits, where x must also be at most 2^63.
+__attribute__((const)) static inline uint64_t next_pow2_64(uint64_t x) { assert(x > 0 && x <= (1ull << 63)); return 1ull << (highestbitset((x - 1) | 1) + 1); }
+
+/// Magic LFSR tap constants for maximal length sequences, indexed by bit width. Widths up to 32 are from https://users.ece.cmu.edu/~koopman/lfsr/
+/// and the wider ones are the numerically smallest taps whose period we verified to be 2^width - 1.
+inline constexpr std::array<uint64_t, 65> lfsr_taps = {
+	0, 0x1, 0x3, 0x6,
+	0xC, 0x14, 0x30, 0x60,
+	0xB4, 0x110, 0x240, 0x500,
+	0xE08, 0x1C80, 0x3802, 0x6000,
+	0xB400, 0x10004, 0x20013, 0x40013,
+	0x80004, 0x100002, 0x200001, 0x400010,
+	0x80000D, 0x1000004, 0x2000023, 0x4000013,
+	0x8000004, 0x10000002, 0x20000029, 0x40000004,
+	0x80000057, 0x100000029, 0x200000073, 0x400000002,
+	0x80000003B, 0x100000001F, 0x2000000031, 0x4000000008,
+	0x800000001C, 0x10000000004, 0x2000000001F, 0x4000000002C,
+	0x80000000032, 0x10000000000D, 0x200000000097, 0x400000000010,
+	0x80000000005B, 0x1000000000038, 0x200000000000E, 0x4000000000025,
+	0x8000000000004, 0x10000000000023, 0x2000000000003E, 0x40000000000023,
+	0x8000000000004A, 0x100000000000016, 0x200000000000031, 0x40000000000003D,
+	0x800000000000001, 0x1000000000000013, 0x2000000000000034, 0x4000000000000001,
+	0x800000000000000D,
+};
+
 /// Get your magic LSFR tap constant for a given bit width.
-uint32_t lfsr_tap(uint32_t size) __attribute__((const));
+__attribute__((const)) static inline constexpr uint64_t lfsr_tap(uint32_t size) { assert(size > 0 && size <= 64); return lfsr_taps[size]; }
 
 /// Flexible linear feedback shift register. Get the magic tap constant for your bit length with lsfr_tap(). Your value will be stored in 'state'.
-static inline constexpr void lfsr_next(uint64_t& state, uint32_t tap) { const uint_fast32_t lsb = state & 1; state >>= 1; state ^= (-lsb) & tap; }
+static inline constexpr void lfsr_next(uint64_t& state, uint64_t tap) { const uint64_t lsb = state & 1; state >>= 1; state ^= (-lsb) & tap; }
+
+/// Jump an LFSR 'steps' calls to lfsr_next() ahead in O(bits^2 log steps) time. The step is linear over GF(2), so we square its bit matrix instead of stepping.
+uint64_t lfsr_skip(uint64_t state, uint64_t tap, uint32_t bits, uint64_t steps) __attribute__((const));
+
+/// Fill a 256 entry table that advances an LFSR eight steps at once with `state = (state >> 8) ^ table[state & 0xff]`.
+void lfsr_stride_table(uint64_t tap, uint64_t* table);
 
 /// Generate valid LFSR input state. Call lfsr_next() to get your first value.
-static inline constexpr __attribute__((const))  uint64_t lfsr_init(uint64_t state, uint32_t bits) { assert(bits > 0 && bits < 64); return fastrange(splitmix64(state), 1, 1ull << bits); }
+static inline constexpr __attribute__((const)) uint64_t lfsr_init(uint64_t state, uint32_t bits)
+{
+	assert(bits > 0 && bits <= 64);
+	return (bits < 64) ? fastrange(splitmix64(state), 1, 1ull << bits) : std::max<uint64_t>(splitmix64(state), 1);
+}
 
 /// CPU time measurement
 static inline uint64_t cpu_gettime() { struct timespec t; clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t); return ((uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec); }
 
 /// Circular distance, see https://biowpn.github.io/bioweapon/2026/03/14/circular-distance.html
 static inline int32_t circular_distance(uint32_t a, uint32_t b) { return b - a; }
+
+// -- Bulk kernels --
+
+/// Instruction set levels for the bulk kernels below. The best one the CPU supports is picked on first use, unless the DICEY_CPU_LEVEL
+/// environment variable names a lower one ("scalar", "sse42", "avx2" or "avx512"). Every level gives bit identical results.
+enum class cpu_level { scalar, sse42, avx2, avx512 };
+
+/// Function attributes for building a kernel at each level, for use together with cpu_level_active(). They also ask for -O3, since -O2
+/// does not vectorize loops of unknown length. Only for x86-64.
+#ifdef __clang__
+#define DICEY_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DICEY_TARGET(isa) __attribute__((target(isa), optimize("O3")))
+#endif
+#define DICEY_SSE42 DICEY_TARGET("sse4.2,popcnt")
+#define DICEY_AVX2 DICEY_TARGET("avx2,bmi2,popcnt")
+#define DICEY_AVX512 DICEY_TARGET("avx512f,avx512vl,avx512dq,avx512bw,avx2,bmi2,popcnt")
+
+/// The best level this CPU supports.
+cpu_level cpu_level_detect();
+
+/// The level currently used by the bulk kernels.
+cpu_level cpu_level_active();
+
+/// Change the level used by the bulk kernels, clamped to what the CPU supports. Returns the level actually used. Not thread safe,
+/// this is meant for tests and benchmarks.
+cpu_level cpu_level_set(cpu_level level);
+
+/// Name of the level, as used by DICEY_CPU_LEVEL.
+const char* cpu_level_name(cpu_level level);
+
+/// Integer square roots of 'n' values. Uses the digit by digit method, see https://en.wikipedia.org/wiki/Integer_square_root#Digit-by-digit_algorithm
+void isqrt_n(const uint64_t* in, uint64_t* out, size_t n);
+
+/// The same for 32 bits
+void isqrt32_n(const uint32_t* in, uint32_t* out, size_t n);
+
+/// Step 'n' independent xorshift64 generators once each. Their states must be non-zero.
+void xorshift64_n(uint64_t* state, size_t n);
+
+/// Snap 'n' random values into the range [low, high] like fastrange() does.
+void fastrange_n(const uint64_t* in, uint64_t low, uint64_t high, uint64_t* out, size_t n);
+
+/// Hash 'n' values with splitmix64(). This is the building block for deriving many seeds at once.
+void splitmix64_n(const uint64_t* in, uint64_t* out, size_t n);
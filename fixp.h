@@ -6,86 +6,393 @@
 #include <stdint.h>
 #include <compare>
 
-// -- Constants --
-
-constexpr int64_t fraction_bits = 24;
-constexpr int64_t integer_bits = 63 - fraction_bits;
-constexpr int64_t fp_multiplier = 1 << fraction_bits;
+#include "dmath.h"
+#include "direction.h"
 
 // -- Types --
 
+/// Type for the intermediate results of multiplication and division, with room for twice the bits.
+template<typename Storage> struct fixed_wide;
+template<> struct fixed_wide<int16_t> { using type = int32_t; };
+template<> struct fixed_wide<int32_t> { using type = int64_t; };
+template<> struct fixed_wide<int64_t> { using type = __int128; };
+
+/// Fixed point number with 'F' fraction bits in a signed 'Storage' integer. Multiplication and division go through the next wider type, so they
+/// do not overflow in between. Conversions between different layouts must be explicit, since they can lose precision or range.
 // Signed bitshifts are implementation defined until c++20 but it works as c++20 everywhere we care about.
-struct fixp
+template<int F, typename Storage = int64_t>
+struct fixed
 {
-	fixp(float x) : val(x * fp_multiplier) {}
-	fixp(double x) : val(x * fp_multiplier) {}
-	fixp(unsigned x) : val((int64_t)x << fraction_bits) {}
-	fixp(uint64_t x) : val(x << fraction_bits) {}
-	fixp(int x) : val((int64_t)x << fraction_bits) {}
-	fixp(const fixp& x) : val(x.val) {}
-	fixp() : val(0) {}
-
-	inline float tofloat() const { return (double)val / (double)fp_multiplier; }
-	inline double todouble() const { return (double)val / (double)fp_multiplier; }
-	inline int toint() const { return val >> fraction_bits; }
-
-	inline fixp& operator+=(const fixp& rhs) { val += rhs.val; return *this; }
-	inline fixp& operator-=(const fixp& rhs) { val -= rhs.val; return *this; }
-	inline fixp& operator*=(const fixp& rhs) { val *= rhs.val; val >>= fraction_bits; return *this; }
-	inline fixp& operator/=(const fixp& rhs) { val = (val << fraction_bits) / rhs.val; return *this; }
-
-	auto operator<=>(const fixp&) const = default;
-
-	int64_t val;
+	static_assert(F > 0 && F < (int)sizeof(Storage) * 8 - 1);
+	using storage = Storage;
+	using wide = typename fixed_wide<Storage>::type;
+	static constexpr int fraction_bits = F;
+	static constexpr Storage multiplier = (Storage)1 << F;
+
+	constexpr fixed(float x) : val(x * multiplier) {}
+	constexpr fixed(double x) : val(x * multiplier) {}
+	constexpr fixed(unsigned x) : val((Storage)x << F) {}
+	constexpr fixed(uint64_t x) : val((Storage)(x << F)) {}
+	constexpr fixed(int x) : val((Storage)x << F) {}
+	constexpr fixed(const fixed& x) : val(x.val) {}
+	constexpr fixed() : val(0) {}
+	template<int F2, typename S2> constexpr explicit fixed(const fixed<F2, S2>& x) : val(F >= F2 ? (Storage)x.val << (F - F2) : (Storage)(x.val >> (F2 - F))) {}
+
+	constexpr fixed& operator=(const fixed& x) = default;
+
+	inline float tofloat() const { return (double)val / (double)multiplier; }
+	inline double todouble() const { return (double)val / (double)multiplier; }
+	inline int toint() const { return val >> F; }
+
+	inline constexpr fixed& operator+=(const fixed& rhs) { val += rhs.val; return *this; }
+	inline constexpr fixed& operator-=(const fixed& rhs) { val -= rhs.val; return *this; }
+	inline constexpr fixed& operator*=(const fixed& rhs) { val = ((wide)val * rhs.val) >> F; return *this; }
+	inline constexpr fixed& operator/=(const fixed& rhs) { val = ((wide)val << F) / rhs.val; return *this; }
+
+	friend constexpr fixed operator+(fixed lhs, const fixed& rhs) { lhs += rhs; return lhs; }
+	friend constexpr fixed operator-(fixed lhs, const fixed& rhs) { lhs -= rhs; return lhs; }
+	friend constexpr fixed operator-(const fixed& s) { fixed r; r.val = -s.val; return r; }
+	friend constexpr fixed operator*(fixed lhs, const fixed& rhs) { lhs *= rhs; return lhs; }
+	friend constexpr fixed operator/(fixed lhs, const fixed& rhs) { lhs /= rhs; return lhs; }
+
+	auto operator<=>(const fixed&) const = default;
+
+	Storage val;
 };
-inline fixp operator+(fixp lhs, const fixp& rhs) { lhs += rhs; return lhs; }
-inline fixp operator-(fixp lhs, const fixp& rhs) { lhs -= rhs; return lhs; }
-inline fixp operator-(const fixp& s) { return -s; }
-inline fixp operator*(fixp lhs, const fixp& rhs) { lhs *= rhs; return lhs; }
-inline fixp operator/(fixp lhs, const fixp& rhs) { lhs /= rhs; return lhs; }
 
-struct ivec2
+template<typename T>
+struct fixed_vec2
 {
-	fixp x;
-	fixp y;
+	T x;
+	T y;
 };
 
-struct aabb
+template<typename T>
+struct fixed_aabb
 {
-	ivec2 min;
-	ivec2 max;
+	fixed_vec2<T> min;
+	fixed_vec2<T> max;
 
-	ivec2 center() const { return ivec2{ (min.x + max.x) / 2, (min.y + max.y) / 2 }; }
+	fixed_vec2<T> center() const { return fixed_vec2<T>{ (min.x + max.x) / 2, (min.y + max.y) / 2 }; }
 };
 
+/// The default layout, Q39.24 in 64 bits
+using fixp = fixed<24, int64_t>;
+using ivec2 = fixed_vec2<fixp>;
+using aabb = fixed_aabb<fixp>;
+
+/// A compact Q15.16 layout in 32 bits, for when the range is enough and you want half the memory
+using fixp16 = fixed<16, int32_t>;
+using ivec2_16 = fixed_vec2<fixp16>;
+using aabb16 = fixed_aabb<fixp16>;
+
+// -- Constants --
+
+constexpr int64_t fraction_bits = fixp::fraction_bits;
+constexpr int64_t integer_bits = 63 - fraction_bits;
+constexpr int64_t fp_multiplier = fixp::multiplier;
+
 // -- Functions --
+// These work on any layout. The overloads for plain fixp at the end also accept anything that converts to fixp, like fixp_pow(0, 5).
+
+/// Reciprocal square root of a positive 128 bit integer 'v', as 'y' in Q63 with 1/sqrt(v) = y * 2^-(63 + e). Also returns the normalized
+/// value 'm' in Q62, so that v = m * 2^(2e - 62). Seeds from the same table as isqrt() and does two Newton steps, for about 40 good bits.
+static inline uint64_t fixp_rsqrt_q63(__uint128_t v, uint64_t& m, int& e)
+{
+	assert(v > 0);
+	const uint64_t hi = v >> 64;
+	e = (hi ? 64 + highestbitset(hi) : highestbitset((uint64_t)v)) >> 1;
+	m = (2 * e >= 62) ? (uint64_t)(v >> (2 * e - 62)) : (uint64_t)v << (62 - 2 * e);
+	uint64_t y = (uint64_t)isqrt_seed[(m >> 54) - 256] << 47;
+	y = rsqrt_step_q62(m, y);
+	return rsqrt_step_q62(m, y);
+}
+
+/// Square root, rounded down. Integer math only, so it gives the same result everywhere. 'x' must not be negative.
+template<int F, typename S> static inline fixed<F, S> fixp_sqrt(fixed<F, S> x)
+{
+	assert(x.val >= 0);
+	fixed<F, S> r;
+	if (x.val <= 0) return r;
+	if ((uint64_t)x.val < (1ull << (64 - F))) { r.val = isqrt((uint64_t)x.val << F); return r; } // fits in 64 bits
+	const __uint128_t v = (__uint128_t)x.val << F;
+	uint64_t m;
+	int e;
+	uint64_t y = fixp_rsqrt_q63(v, m, e);
+	y = rsqrt_step_q62(m, y); // the result can have more than 32 bits, so one more step
+	uint64_t s = ((__uint128_t)m * y) >> (125 - e);
+	while ((__uint128_t)s * s > v) s--;
+	while (v - (__uint128_t)s * s > 2 * (__uint128_t)s) s++;
+	r.val = s;
+	return r;
+}
+
+/// Reciprocal square root, 1/sqrt(x), rounded down. Integer math only. 'x' must be positive.
+template<int F, typename S> static inline fixed<F, S> fixp_rsqrt(fixed<F, S> x)
+{
+	static_assert(3 * F + 1 < 128);
+	assert(x.val > 0);
+	// We want floor(2^(3F/2) / sqrt(x.val)). For odd F we double x.val to make the power of two even, then it is the largest r
+	// with r * r * v <= 2^(2K). The products are close to 2^(2K), so they fit.
+	constexpr int odd = (3 * F) & 1;
+	constexpr int K = (3 * F + odd) / 2;
+	const uint64_t v = (uint64_t)x.val << odd;
+	uint64_t m;
+	int e;
+	const uint64_t y = fixp_rsqrt_q63(v, m, e);
+	uint64_t r = y >> (63 - K + e);
+	constexpr __uint128_t one = (__uint128_t)1 << (2 * K);
+	while ((__uint128_t)r * r * v > one) r--;
+	while ((__uint128_t)(r + 1) * (r + 1) * v <= one) r++;
+	fixed<F, S> result;
+	result.val = r;
+	return result;
+}
+
+template<int F, typename S> static inline fixed<F, S> fixp_pow(fixed<F, S> base, unsigned exp) { fixed<F, S> result = 1; for (;;) { if (exp & 1) result *= base; exp >>= 1; if (!exp) break; base *= base; } return result; }
+template<int F, typename S> static inline fixed<F, S> fixp_intersect(fixed<F, S> da, fixed<F, S> db) { return da / (da - db); }
+template<typename T> static inline T fixp_dot(fixed_vec2<T> a, fixed_vec2<T> b) { return a.x * b.x + a.y * b.y; }
+template<typename T> static inline T fixp_distance(fixed_vec2<T> a, fixed_vec2<T> b) { T dx = a.x - b.x; T dy = a.y - b.y; return fixp_sqrt(dx * dx + dy * dy); }
+template<typename T> static inline T fixp_length(fixed_vec2<T> a) { return fixp_sqrt(fixp_dot(a, a)); }
+
+/// Unit vector in the direction of 'a', or zero if 'a' is zero. Takes the exact sum of squares in 128 bits, so it does not overflow for long vectors,
+/// and then one reciprocal square root and two multiplies. Rounds toward zero like division does.
+template<typename T> static inline fixed_vec2<T> fixp_normal(fixed_vec2<T> a)
+{
+	fixed_vec2<T> r;
+	const uint64_t ax = a.x.val < 0 ? -(uint64_t)a.x.val : a.x.val;
+	const uint64_t ay = a.y.val < 0 ? -(uint64_t)a.y.val : a.y.val;
+	const __uint128_t sum = (__uint128_t)ax * ax + (__uint128_t)ay * ay;
+	if (sum == 0) return r;
+	uint64_t m;
+	int e;
+	uint64_t y = fixp_rsqrt_q63(sum, m, e);
+	y = rsqrt_step_q62(m, y);
+	// Newton steps for 1/sqrt only ever undershoot, so nudge it up by a bit more than the remaining error. Otherwise exact results like
+	// (0, -1) would round down to the next value toward zero.
+	y += y >> 56;
+	const int64_t nx = ((__uint128_t)ax * y) >> (63 - T::fraction_bits + e);
+	const int64_t ny = ((__uint128_t)ay * y) >> (63 - T::fraction_bits + e);
+	r.x.val = a.x.val < 0 ? -nx : nx;
+	r.y.val = a.y.val < 0 ? -ny : ny;
+	return r;
+}
+
+template<typename T> static inline bool fixp_overlaps(fixed_aabb<T> a, fixed_aabb<T> b) { int d0 = b.max.x < a.min.x; int d1 = a.max.x < b.min.x; int d2 = b.max.y < a.min.y; int d3 = a.max.y < b.min.y; return !(d0 | d1 | d2 | d3); }
+
+// -- Inverse sine and cosine --
+
+/// How exact fixp_asin and fixp_acos are, traded for speed. Max errors against the exact values for fixp, over every input, are:
+///  fast: 3.3e-4, with a second degree polynomial and a square root that is not rounded exactly
+///  normal: 7e-5, with a third degree polynomial (A&S 4.4.45)
+///  precise: 3.8e-7, with a seventh degree polynomial (A&S 4.4.46)
+/// For fixp, the fast tier saves about a third of the time of the normal one, and the precise one takes up to half again as long. With only 16 fraction bits, the
+/// rounding in each step adds up to 8.5e-5, so fixp16 gains little from 'precise'.
+enum class fixp_accuracy { fast, normal, precise };
 
-static inline fixp fixp_sqrt(fixp x) { fixp r = sqrt(x.todouble()); r.val = std::min(r.val, (int64_t)INT64_MAX); while (r * r > x) r.val--; while (x - r * r > r * 2) r.val++; return r; }
-static inline fixp fixp_pow(fixp base, unsigned exp) { fixp result = 1; for (;;) { if (exp & 1) result *= base; exp >>= 1; if (!exp) break; base *= base; } return result; }
-static inline fixp fixp_intersect(fixp da, fixp db) { return da / (da - db); }
-static inline fixp fixp_dot(ivec2 a, ivec2 b) { return a.x * b.x + a.y * b.y; }
-static inline fixp fixp_distance(ivec2 a, ivec2 b) { fixp dx = a.x - b.x; fixp dy = a.y - b.y; return fixp_sqrt(dx * dx + dy * dy); }
-static inline fixp fixp_length(ivec2 a) { return fixp_sqrt(fixp_dot(a, a)); }
-static inline ivec2 fixp_normal(ivec2 a) { const fixp len = fixp_length(a); ivec2 r; r.x = a.x / len; r.y = a.y / len; return r; }
-static inline bool fixp_overlaps(aabb a, aabb b) { int d0 = b.max.x < a.min.x; int d1 = a.max.x < b.min.x; int d2 = b.max.y < a.min.y; int d3 = a.max.y < b.min.y; return !(d0 | d1 | d2 | d3); }
-
-// asin approximation via A&S 4.4.57 (Estrin form), valid for x in [-1, 1], max error ~7e-5
-// Adapted from https://16bpp.net/blog/post/even-faster-asin-was-staring-right-at-me/
-static inline fixp fixp_asin(fixp x)
+/// Square root of 'x' in [0, 1] with a single Newton step from the table seed, and no rounding fix up. Up to 2e-6 too small.
+template<int F, typename S> static inline fixed<F, S> fixp_sqrt_unit_fast(fixed<F, S> x)
 {
-	constexpr int64_t c_halfpi = (int64_t)(1.5707963267948966 * fp_multiplier);
-	constexpr int64_t c_a0 = (int64_t)(1.5707288 * fp_multiplier);
-	constexpr int64_t c_a1 = (int64_t)(-0.2121144 * fp_multiplier);
-	constexpr int64_t c_a2 = (int64_t)(0.0742610 * fp_multiplier);
-	constexpr int64_t c_a3 = (int64_t)(-0.0187293 * fp_multiplier);
-
-	fixp abs_x; abs_x.val = x.val < 0 ? -x.val : x.val;
-	const fixp x2 = abs_x * abs_x;
-	fixp a0; a0.val = c_a0; fixp a1; a1.val = c_a1; fixp a2; a2.val = c_a2; fixp a3; a3.val = c_a3;
-	const fixp p = (a3 * abs_x + a2) * x2 + (a1 * abs_x + a0);
-	fixp one_minus_x; one_minus_x.val = (int64_t)fp_multiplier - abs_x.val;
-	const fixp x_diff = fixp_sqrt(one_minus_x);
-	fixp result; result.val = c_halfpi - (x_diff * p).val;
+	static_assert(F <= 31);
+	fixed<F, S> r;
+	if (x.val <= 0) return r;
+	const uint64_t w = (uint64_t)x.val << F;
+	const int e = highestbitset(w) >> 1;
+	const uint64_t m = w << (62 - 2 * e);
+	uint64_t y = (uint64_t)isqrt_seed[(m >> 54) - 256] << 47;
+	y = rsqrt_step_q62(m, y);
+	r.val = ((__uint128_t)m * y) >> (125 - e);
+	return r;
+}
+
+// Inverse sine and cosine as in https://16bpp.net/blog/post/even-faster-asin-was-staring-right-at-me/, using acos(x) = sqrt(1 - x) * p(x)
+// for x in [0, 1] with polynomials from Abramowitz and Stegun (A&S 4.4.45 and 4.4.46), or fitted to minimax error for 'fast'. asin and acos
+// for all of [-1, 1] follow from it by symmetry. Polynomials are in Estrin form.
+template<fixp_accuracy A, int F, typename S> static inline fixed<F, S> fixp_acos_abs(fixed<F, S> x)
+{
+	using T = fixed<F, S>;
+	const auto c = [](double v) { T r; r.val = (S)(v * T::multiplier); return r; };
+	T abs_x; abs_x.val = x.val < 0 ? -x.val : x.val;
+	T one_minus_x; one_minus_x.val = T::multiplier - abs_x.val;
+	if constexpr (A == fixp_accuracy::fast)
+	{
+		const T p = (c(0.0513887) * abs_x + c(-0.2054967)) * abs_x + c(1.5704701);
+		return fixp_sqrt_unit_fast(one_minus_x) * p;
+	}
+	else if constexpr (A == fixp_accuracy::normal)
+	{
+		const T x2 = abs_x * abs_x;
+		const T p = (c(-0.0187293) * abs_x + c(0.0742610)) * x2 + (c(-0.2121144) * abs_x + c(1.5707288));
+		return fixp_sqrt(one_minus_x) * p;
+	}
+	else
+	{
+		const T x2 = abs_x * abs_x;
+		const T x4 = x2 * x2;
+		const T lo = (c(-0.0501743046) * abs_x + c(0.0889789874)) * x2 + (c(-0.2145988016) * abs_x + c(1.5707963050));
+		const T hi = (c(-0.0012624911) * abs_x + c(0.0066700901)) * x2 + (c(-0.0170881256) * abs_x + c(0.0308918810));
+		return fixp_sqrt(one_minus_x) * (hi * x4 + lo);
+	}
+}
+
+/// Arc sine in radians, from -pi/2 to pi/2, for x in [-1, 1]. See fixp_accuracy for the errors.
+template<fixp_accuracy A = fixp_accuracy::normal, int F, typename S> static inline fixed<F, S> fixp_asin(fixed<F, S> x)
+{
+	using T = fixed<F, S>;
+	constexpr S c_halfpi = (S)(1.5707963267948966 * T::multiplier);
+	T result; result.val = c_halfpi - fixp_acos_abs<A>(x).val;
 	if (x.val < 0) result.val = -result.val;
 	return result;
 }
+
+/// Arc cosine in radians, from 0 to pi, for x in [-1, 1]. See fixp_accuracy for the errors.
+template<fixp_accuracy A = fixp_accuracy::normal, int F, typename S> static inline fixed<F, S> fixp_acos(fixed<F, S> x)
+{
+	using T = fixed<F, S>;
+	constexpr S c_pi = (S)(3.141592653589793 * T::multiplier);
+	T result = fixp_acos_abs<A>(x);
+	if (x.val < 0) result.val = c_pi - result.val;
+	return result;
+}
+
+// -- Trigonometry on directions --
+// Angles are a `direction` from direction.h, where the full circle is 65536, counterclockwise from the positive x axis. This wraps around
+// by itself and takes no fixed point math to reduce.
+
+/// Sine and cosine of a direction, from isin() and icos(). Those have 12 fraction bits, so the max error is 2^-11, about 5e-4.
+template<typename T = fixp> static inline T fixp_sin(direction d) { static_assert(T::fraction_bits >= 12); T r; r.val = (typename T::storage)isin(d) << (T::fraction_bits - 12); return r; }
+template<typename T = fixp> static inline T fixp_cos(direction d) { return fixp_sin<T>((direction)(d + 16384U)); }
+
+/// Unit vector pointing in direction 'd'.
+template<typename T = fixp> static inline fixed_vec2<T> fixp_from_direction(direction d) { return fixed_vec2<T>{ fixp_cos<T>(d), fixp_sin<T>(d) }; }
+
+/// Direction of the vector (x, y), like atan2(y, x) but as a direction. Off by at most one, that is 2pi/65536 or about 1e-4 radians.
+/// Zero gives zero. Reduces to the first octant and then uses A&S 4.4.47 (error 1e-5 radians) with the coefficients scaled to give a
+/// direction directly, in integer math only.
+template<typename T> static inline direction fixp_atan2(T y, T x)
+{
+	uint64_t ax = x.val < 0 ? 0 - (uint64_t)(int64_t)x.val : (uint64_t)(int64_t)x.val;
+	uint64_t ay = y.val < 0 ? 0 - (uint64_t)(int64_t)y.val : (uint64_t)(int64_t)y.val;
+	const bool steep = ay > ax;
+	uint64_t lo = steep ? ax : ay;
+	uint64_t hi = steep ? ay : ax;
+	if (hi == 0) return 0;
+	// Keep 32 bits of the larger value, which is plenty for the ratio, so that it takes a 64 bit division only
+	const int drop = std::max(0, highestbitset(hi) - 31);
+	lo >>= drop;
+	hi >>= drop;
+	const int64_t t = (lo << 30) / hi; // in [0, 1] in Q30
+	const int64_t t2 = (t * t) >> 30;
+	constexpr double scale = 65536.0 * 65536.0 / (2.0 * 3.141592653589793); // to directions in Q16
+	constexpr int64_t c1 = 0.9998660 * scale + 0.5, c3 = -0.3302995 * scale - 0.5, c5 = 0.1801410 * scale + 0.5, c7 = -0.0851330 * scale - 0.5, c9 = 0.0208351 * scale + 0.5;
+	int64_t p = c9;
+	p = c7 + ((p * t2) >> 30);
+	p = c5 + ((p * t2) >> 30);
+	p = c3 + ((p * t2) >> 30);
+	p = c1 + ((p * t2) >> 30);
+	uint32_t a = (uint32_t)((t * p + (1ll << 45)) >> 46); // up to 8192, an eighth of the circle
+	if (steep) a = 16384 - a;
+	if (x.val < 0) a = 32768 - a;
+	if (y.val < 0) a = 65536 - a;
+	return (direction)a;
+}
+
+template<typename T> static inline direction fixp_atan2(fixed_vec2<T> v) { return fixp_atan2(v.y, v.x); }
+
+/// Direction of an angle in radians, rounded to nearest. Any angle works, since directions wrap around.
+template<int F, typename S> static inline direction fixp_to_direction(fixed<F, S> radians)
+{
+	constexpr __int128 scale = (__int128)(65536.0 / (2.0 * 3.141592653589793) * (double)(1ll << 40)); // Q40
+	return (direction)(uint64_t)(((__int128)radians.val * scale + ((__int128)1 << (F + 39))) >> (F + 40));
+}
+
+/// Angle of a direction in radians, from 0 up to 2pi.
+template<typename T = fixp> static inline T fixp_radians(direction d)
+{
+	constexpr __int128 scale = (__int128)(2.0 * 3.141592653589793 / 65536.0 * (double)(1ll << 62)); // Q62
+	T r; r.val = (typename T::storage)(((__int128)d * scale) >> (62 - T::fraction_bits));
+	return r;
+}
+
+// Array versions, for bulk updates like steering. They give the same results as the functions above.
+
+template<typename T> static inline void fixp_sincos_n(const direction* in, T* sin_out, T* cos_out, size_t n) { for (size_t i = 0; i < n; i++) { sin_out[i] = fixp_sin<T>(in[i]); cos_out[i] = fixp_cos<T>(in[i]); } }
+template<typename T> static inline void fixp_atan2_n(const T* y, const T* x, direction* out, size_t n) { for (size_t i = 0; i < n; i++) out[i] = fixp_atan2(y[i], x[i]); }
+template<fixp_accuracy A = fixp_accuracy::normal, typename T> static inline void fixp_acos_n(const T* in, T* out, size_t n) { for (size_t i = 0; i < n; i++) out[i] = fixp_acos<A>(in[i]); }
+
+/// Divides by the same value over and over, with multiplies and a shift instead of a division, by working out a reciprocal up front.
+/// Gives exactly the same results as operator/, even where that overflows, since both wrap around the same way. The reciprocal is
+/// ceil(2^(N + l) / d) for N bit dividends and 2^(l - 1) < d <= 2^l, see Granlund and Montgomery, "Division by invariant integers
+/// using multiplication". It has up to 'bits' + F + 2 bits, so it is kept in two halves split at the storage size. This pays off most
+/// for fixp, where operator/ needs a 128 bit division, while recent CPUs already divide the 64 bit intermediates of fixp16 quickly.
+template<typename T>
+struct fixed_divider
+{
+	using storage = typename T::storage;
+	static constexpr int bits = sizeof(storage) * 8;
+
+	explicit fixed_divider(T d) : divisor(d)
+	{
+		assert(d.val != 0);
+		negative = d.val < 0;
+		const uint64_t ad = negative ? 0 - (uint64_t)(int64_t)d.val : (uint64_t)(int64_t)d.val;
+		shift = ad > 1 ? highestbitset(ad - 1) + 1 : 0;
+		// The dividends are val << F, so N is the storage bits plus F
+		const int k = bits + T::fraction_bits + shift;
+		__uint128_t q, r;
+		if (k < 128) { q = ((__uint128_t)1 << k) / ad; r = ((__uint128_t)1 << k) % ad; }
+		else
+		{
+			const __uint128_t n = (__uint128_t)1 << (k - 64);
+			const __uint128_t rest = (n % ad) << 64;
+			q = ((n / ad) << 64) | (uint64_t)(rest / ad);
+			r = rest % ad;
+		}
+		q += r != 0;
+		magic_lo = (uint64_t)q & (~0ull >> (64 - bits));
+		magic_hi = (uint64_t)(q >> bits);
+	}
+
+	/// x / divisor
+	inline T divide(T x) const
+	{
+		const uint64_t sign = (x.val < 0) != negative ? ~0ull : 0;
+		const uint64_t ax = x.val < 0 ? 0 - (uint64_t)(int64_t)x.val : (uint64_t)(int64_t)x.val;
+		uint64_t q;
+		if constexpr (bits == 64) q = (((__uint128_t)ax * magic_hi + (uint64_t)(((__uint128_t)ax * magic_lo) >> 64)) >> shift);
+		else q = (ax * magic_hi + ((ax * magic_lo) >> bits)) >> shift; // fits in 64 bits, with no 128 bit multiplies
+		T r;
+		r.val = (storage)((q ^ sign) - sign);
+		return r;
+	}
+
+	/// out[i] = in[i] / divisor
+	inline void divide_n(const T* in, T* out, size_t n) const
+	{
+		const fixed_divider div = *this; // a local copy, since the stores to 'out' could otherwise alias our members
+		for (size_t i = 0; i < n; i++) out[i] = div.divide(in[i]);
+	}
+
+	T divisor;
+	uint64_t magic_lo;
+	uint64_t magic_hi;
+	int shift;
+	bool negative;
+};
+
+using fixp_divider = fixed_divider<fixp>;
+using fixp16_divider = fixed_divider<fixp16>;
+
+static inline fixp fixp_sqrt(fixp x) { return fixp_sqrt<fraction_bits, int64_t>(x); }
+static inline fixp fixp_rsqrt(fixp x) { return fixp_rsqrt<fraction_bits, int64_t>(x); }
+static inline fixp fixp_pow(fixp base, unsigned exp) { return fixp_pow<fraction_bits, int64_t>(base, exp); }
+static inline fixp fixp_intersect(fixp da, fixp db) { return fixp_intersect<fraction_bits, int64_t>(da, db); }
+static inline fixp fixp_dot(ivec2 a, ivec2 b) { return fixp_dot<fixp>(a, b); }
+static inline fixp fixp_distance(ivec2 a, ivec2 b) { return fixp_distance<fixp>(a, b); }
+static inline fixp fixp_length(ivec2 a) { return fixp_length<fixp>(a); }
+static inline ivec2 fixp_normal(ivec2 a) { return fixp_normal<fixp>(a); }
+static inline bool fixp_overlaps(aabb a, aabb b) { return fixp_overlaps<fixp>(a, b); }
+static inline fixp fixp_asin(fixp x) { return fixp_asin<fixp_accuracy::normal>(x); }
+static inline fixp fixp_acos(fixp x) { return fixp_acos<fixp_accuracy::normal>(x); }
+static inline direction fixp_atan2(fixp y, fixp x) { return fixp_atan2<fixp>(y, x); }
+static inline direction fixp_to_direction(fixp radians) { return fixp_to_direction<fraction_bits, int64_t>(radians); }
@@ -0,0 +1,119 @@
+#include "fixp_soa.h"
+
+namespace
+{
+	struct fixp_soa_kernels
+	{
+		void (*axpy)(int64_t* p, const int64_t* v, int64_t d, size_t n);
+		void (*dot)(const int64_t* ax, const int64_t* ay, const int64_t* bx, const int64_t* by, int64_t* out, size_t n);
+		void (*distance_sq)(const int64_t* ax, const int64_t* ay, const int64_t* bx, const int64_t* by, int64_t* out, size_t n);
+		void (*distance_sq_point)(const int64_t* ax, const int64_t* ay, int64_t bx, int64_t by, int64_t* out, size_t n);
+		void (*clamp)(int64_t* p, int64_t lo, int64_t hi, size_t n);
+		void (*axpy16)(int32_t* p, const int32_t* v, int32_t d, size_t n);
+		void (*dot16)(const int32_t* ax, const int32_t* ay, const int32_t* bx, const int32_t* by, int32_t* out, size_t n);
+		void (*distance_sq16)(const int32_t* ax, const int32_t* ay, const int32_t* bx, const int32_t* by, int32_t* out, size_t n);
+		void (*distance_sq_point16)(const int32_t* ax, const int32_t* ay, int32_t bx, int32_t by, int32_t* out, size_t n);
+		void (*clamp16)(int32_t* p, int32_t lo, int32_t hi, size_t n);
+	};
+}
+
+#define DICEY_SOA_KERNELS(level, attr, split) \
+	attr static void axpy_##level(int64_t* p, const int64_t* v, int64_t d, size_t n) { fixp_axpy_raw<fixp::fraction_bits, split>(p, v, d, n); } \
+	attr static void dot_##level(const int64_t* ax, const int64_t* ay, const int64_t* bx, const int64_t* by, int64_t* out, size_t n) { fixp_dot_raw<fixp::fraction_bits, split>(ax, ay, bx, by, out, n); } \
+	attr static void distance_sq_##level(const int64_t* ax, const int64_t* ay, const int64_t* bx, const int64_t* by, int64_t* out, size_t n) { fixp_distance_sq_raw<fixp::fraction_bits, split>(ax, ay, bx, by, out, n); } \
+	attr static void distance_sq_point_##level(const int64_t* ax, const int64_t* ay, int64_t bx, int64_t by, int64_t* out, size_t n) { fixp_distance_sq_raw<fixp::fraction_bits, split>(ax, ay, bx, by, out, n); } \
+	attr static void clamp_##level(int64_t* p, int64_t lo, int64_t hi, size_t n) { fixp_clamp_raw(p, lo, hi, n); } \
+	attr static void axpy16_##level(int32_t* p, const int32_t* v, int32_t d, size_t n) { fixp_axpy_raw<fixp16::fraction_bits, split>(p, v, d, n); } \
+	attr static void dot16_##level(const int32_t* ax, const int32_t* ay, const int32_t* bx, const int32_t* by, int32_t* out, size_t n) { fixp_dot_raw<fixp16::fraction_bits, split>(ax, ay, bx, by, out, n); } \
+	attr static void distance_sq16_##level(const int32_t* ax, const int32_t* ay, const int32_t* bx, const int32_t* by, int32_t* out, size_t n) { fixp_distance_sq_raw<fixp16::fraction_bits, split>(ax, ay, bx, by, out, n); } \
+	attr static void distance_sq_point16_##level(const int32_t* ax, const int32_t* ay, int32_t bx, int32_t by, int32_t* out, size_t n) { fixp_distance_sq_raw<fixp16::fraction_bits, split>(ax, ay, bx, by, out, n); } \
+	attr static void clamp16_##level(int32_t* p, int32_t lo, int32_t hi, size_t n) { fixp_clamp_raw(p, lo, hi, n); } \
+	static const fixp_soa_kernels kernels_##level = { axpy_##level, dot_##level, distance_sq_##level, distance_sq_point_##level, clamp_##level, \
+		axpy16_##level, dot16_##level, distance_sq16_##level, distance_sq_point16_##level, clamp16_##level };
+
+// Only AVX-512 splits the 64 bit multiplies, see fixed_mul_raw. Built out of 32 bit multiplies, AVX2 was a third slower than the scalar
+// 128 bit multiply. The 32 bit layout vectorizes at every level.
+DICEY_SOA_KERNELS(scalar, , false)
+#if defined(__x86_64__) && defined(__GNUC__)
+DICEY_SOA_KERNELS(sse42, DICEY_SSE42, false)
+DICEY_SOA_KERNELS(avx2, DICEY_AVX2, false)
+DICEY_SOA_KERNELS(avx512, DICEY_AVX512, true)
+static const fixp_soa_kernels* const kernel_table[] = { &kernels_scalar, &kernels_sse42, &kernels_avx2, &kernels_avx512 };
+#else
+static const fixp_soa_kernels* const kernel_table[] = { &kernels_scalar, &kernels_scalar, &kernels_scalar, &kernels_scalar };
+#endif
+
+// Looked up on each call so that cpu_level_set() is respected. That is cheap next to a batch of any useful size.
+static inline const fixp_soa_kernels* kernels() { return kernel_table[(int)cpu_level_active()]; }
+
+void fixp_axpy_n(ivec2_soa& pos, const ivec2_soa& vel, fixp dt)
+{
+	assert(pos.size() == vel.size());
+	kernels()->axpy(pos.x.data(), vel.x.data(), dt.val, pos.size());
+	kernels()->axpy(pos.y.data(), vel.y.data(), dt.val, pos.size());
+}
+
+void fixp_dot_n(const ivec2_soa& a, const ivec2_soa& b, fixp* out)
+{
+	assert(a.size() == b.size());
+	kernels()->dot(a.x.data(), a.y.data(), b.x.data(), b.y.data(), fixed_raw(out), a.size());
+}
+
+void fixp_length_sq_n(const ivec2_soa& a, fixp* out)
+{
+	kernels()->dot(a.x.data(), a.y.data(), a.x.data(), a.y.data(), fixed_raw(out), a.size());
+}
+
+void fixp_distance_sq_n(const ivec2_soa& a, const ivec2_soa& b, fixp* out)
+{
+	assert(a.size() == b.size());
+	kernels()->distance_sq(a.x.data(), a.y.data(), b.x.data(), b.y.data(), fixed_raw(out), a.size());
+}
+
+void fixp_distance_sq_n(const ivec2_soa& a, ivec2 b, fixp* out)
+{
+	kernels()->distance_sq_point(a.x.data(), a.y.data(), b.x.val, b.y.val, fixed_raw(out), a.size());
+}
+
+void fixp_clamp_n(ivec2_soa& pos, aabb box)
+{
+	assert(box.min.x <= box.max.x && box.min.y <= box.max.y);
+	kernels()->clamp(pos.x.data(), box.min.x.val, box.max.x.val, pos.size());
+	kernels()->clamp(pos.y.data(), box.min.y.val, box.max.y.val, pos.size());
+}
+
+void fixp_axpy_n(ivec2_16_soa& pos, const ivec2_16_soa& vel, fixp16 dt)
+{
+	assert(pos.size() == vel.size());
+	kernels()->axpy16(pos.x.data(), vel.x.data(), dt.val, pos.size());
+	kernels()->axpy16(pos.y.data(), vel.y.data(), dt.val, pos.size());
+}
+
+void fixp_dot_n(const ivec2_16_soa& a, const ivec2_16_soa& b, fixp16* out)
+{
+	assert(a.size() == b.size());
+	kernels()->dot16(a.x.data(), a.y.data(), b.x.data(), b.y.data(), fixed_raw(out), a.size());
+}
+
+void fixp_length_sq_n(const ivec2_16_soa& a, fixp16* out)
+{
+	kernels()->dot16(a.x.data(), a.y.data(), a.x.data(), a.y.data(), fixed_raw(out), a.size());
+}
+
+void fixp_distance_sq_n(const ivec2_16_soa& a, const ivec2_16_soa& b, fixp16* out)
+{
+	assert(a.size() == b.size());
+	kernels()->distance_sq16(a.x.data(), a.y.data(), b.x.data(), b.y.data(), fixed_raw(out), a.size());
+}
+
+void fixp_distance_sq_n(const ivec2_16_soa& a, ivec2_16 b, fixp16* out)
+{
+	kernels()->distance_sq_point16(a.x.data(), a.y.data(), b.x.val, b.y.val, fixed_raw(out), a.size());
+}
+
+void fixp_clamp_n(ivec2_16_soa& pos, aabb16 box)
+{
+	assert(box.min.x <= box.max.x && box.min.y <= box.max.y);
+	kernels()->clamp16(pos.x.data(), box.min.x.val, box.max.x.val, pos.size());
+	kernels()->clamp16(pos.y.data(), box.min.y.val, box.max.y.val, pos.size());
+}
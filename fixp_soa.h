@@ -0,0 +1,166 @@
+#pragma once
+
+// Arrays of fixed point 2D vectors, stored as separate x and y arrays, with batched kernels over them.
+//
+// The kernels give exactly the same results as the scalar fixed operators in fixp.h, so code using them agrees bit for bit with code
+// that does not. They are plain branch free loops over the raw integers, so the compiler can vectorize them. For fixp and fixp16 they
+// are built for each instruction set level in fixp_soa.cpp and picked at runtime, see cpu_level in dmath.h.
+
+#include "fixp.h"
+
+#include <type_traits>
+#include <vector>
+
+template<typename T>
+struct fixed_vec2_soa
+{
+	using storage = typename T::storage;
+
+	fixed_vec2_soa() {}
+	explicit fixed_vec2_soa(size_t n) : x(n, 0), y(n, 0) {}
+
+	inline size_t size() const { return x.size(); }
+	void resize(size_t n) { x.resize(n, 0); y.resize(n, 0); }
+	void reserve(size_t n) { x.reserve(n); y.reserve(n); }
+	void push_back(fixed_vec2<T> v) { x.push_back(v.x.val); y.push_back(v.y.val); }
+	inline fixed_vec2<T> get(size_t i) const { fixed_vec2<T> v; v.x.val = x[i]; v.y.val = y[i]; return v; }
+	inline void set(size_t i, fixed_vec2<T> v) { x[i] = v.x.val; y[i] = v.y.val; }
+
+	std::vector<storage> x;
+	std::vector<storage> y;
+};
+
+using ivec2_soa = fixed_vec2_soa<fixp>;
+using ivec2_16_soa = fixed_vec2_soa<fixp16>;
+
+// -- Building blocks --
+
+/// The same as fixed<F, S>::operator*, on raw values. With 'split' set, 64 bit storage avoids the 128 bit multiply, which does not
+/// vectorize, by multiplying 32 bit halves. We only need the bits from F up to F + 64 of the product, and everything above that wraps
+/// away just like the truncation from 128 bits does. It takes four multiplies instead of one though, so it only pays off when vectorized.
+template<int F, typename S, bool split = false> static inline __attribute__((always_inline)) S fixed_mul_raw(S a, S b)
+{
+	if constexpr (sizeof(S) == 8 && split)
+	{
+		static_assert(F <= 32);
+		const uint32_t al = a, ah = (uint64_t)a >> 32;
+		const uint32_t bl = b, bh = (uint64_t)b >> 32;
+		const uint64_t lo = (uint64_t)al * bl;
+		const uint64_t hi = (uint64_t)ah * bh;
+		uint64_t mid = (uint64_t)ah * bl + (uint64_t)al * bh;
+		mid -= (uint64_t)(bl & (uint32_t)(a >> 63)) << 32; // the high halves are signed
+		mid -= (uint64_t)(al & (uint32_t)(b >> 63)) << 32;
+		return (int64_t)((hi << (64 - F)) + (mid << (32 - F)) + (lo >> F));
+	}
+	else
+	{
+		using wide = typename fixed_wide<S>::type;
+		return (S)(((wide)a * b) >> F);
+	}
+}
+
+/// View an array of fixed point values as an array of their raw storage, for the kernels. This relies on fixed<F, S> being nothing but
+/// its storage, which we check here, so the whole array has the layout of one of S.
+template<int F, typename S> static inline S* fixed_raw(fixed<F, S>* p)
+{
+	static_assert(sizeof(fixed<F, S>) == sizeof(S) && alignof(fixed<F, S>) == alignof(S) && std::is_standard_layout_v<fixed<F, S>>);
+	return reinterpret_cast<S*>(p);
+}
+
+// The kernel loops on raw arrays. Always inlined, so that each instruction set level in fixp_soa.cpp gets its own copy, and only the
+// levels with wide vectors split the multiplies.
+
+template<int F, bool split, typename S> static inline __attribute__((always_inline)) void fixp_axpy_raw(S* __restrict p, const S* __restrict v, S d, size_t n)
+{
+	for (size_t i = 0; i < n; i++) p[i] += fixed_mul_raw<F, S, split>(v[i], d);
+}
+
+template<int F, bool split, typename S> static inline __attribute__((always_inline)) void fixp_dot_raw(const S* ax, const S* ay, const S* bx, const S* by, S* __restrict out, size_t n)
+{
+	for (size_t i = 0; i < n; i++) out[i] = fixed_mul_raw<F, S, split>(ax[i], bx[i]) + fixed_mul_raw<F, S, split>(ay[i], by[i]);
+}
+
+template<int F, bool split, typename S> static inline __attribute__((always_inline)) void fixp_distance_sq_raw(const S* ax, const S* ay, const S* bx, const S* by, S* __restrict out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		const S dx = ax[i] - bx[i];
+		const S dy = ay[i] - by[i];
+		out[i] = fixed_mul_raw<F, S, split>(dx, dx) + fixed_mul_raw<F, S, split>(dy, dy);
+	}
+}
+
+template<int F, bool split, typename S> static inline __attribute__((always_inline)) void fixp_distance_sq_raw(const S* ax, const S* ay, S bx, S by, S* __restrict out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		const S dx = ax[i] - bx;
+		const S dy = ay[i] - by;
+		out[i] = fixed_mul_raw<F, S, split>(dx, dx) + fixed_mul_raw<F, S, split>(dy, dy);
+	}
+}
+
+template<typename S> static inline __attribute__((always_inline)) void fixp_clamp_raw(S* __restrict p, S lo, S hi, size_t n)
+{
+	for (size_t i = 0; i < n; i++) p[i] = std::min(std::max(p[i], lo), hi);
+}
+
+// -- Kernels --
+// All arrays must have the same size, and outputs must not overlap the inputs. The templates work for any layout, while the overloads for fixp and
+// fixp16 below them use the best instruction set the CPU has.
+
+/// pos += vel * dt, for each vector.
+template<typename T> static inline void fixp_axpy_n(fixed_vec2_soa<T>& pos, const fixed_vec2_soa<T>& vel, T dt)
+{
+	assert(pos.size() == vel.size());
+	fixp_axpy_raw<T::fraction_bits, false>(pos.x.data(), vel.x.data(), dt.val, pos.size());
+	fixp_axpy_raw<T::fraction_bits, false>(pos.y.data(), vel.y.data(), dt.val, pos.size());
+}
+
+/// out[i] = fixp_dot(a[i], b[i])
+template<typename T> static inline void fixp_dot_n(const fixed_vec2_soa<T>& a, const fixed_vec2_soa<T>& b, T* out)
+{
+	assert(a.size() == b.size());
+	fixp_dot_raw<T::fraction_bits, false>(a.x.data(), a.y.data(), b.x.data(), b.y.data(), fixed_raw(out), a.size());
+}
+
+/// out[i] = fixp_dot(a[i], a[i]), the length squared
+template<typename T> static inline void fixp_length_sq_n(const fixed_vec2_soa<T>& a, T* out)
+{
+	fixp_dot_raw<T::fraction_bits, false>(a.x.data(), a.y.data(), a.x.data(), a.y.data(), fixed_raw(out), a.size());
+}
+
+/// out[i] = dx * dx + dy * dy for the difference between a[i] and b[i], the distance squared
+template<typename T> static inline void fixp_distance_sq_n(const fixed_vec2_soa<T>& a, const fixed_vec2_soa<T>& b, T* out)
+{
+	assert(a.size() == b.size());
+	fixp_distance_sq_raw<T::fraction_bits, false>(a.x.data(), a.y.data(), b.x.data(), b.y.data(), fixed_raw(out), a.size());
+}
+
+/// The same as above, but to a single point, for example to find everything within some range of it.
+template<typename T> static inline void fixp_distance_sq_n(const fixed_vec2_soa<T>& a, fixed_vec2<T> b, T* out)
+{
+	fixp_distance_sq_raw<T::fraction_bits, false>(a.x.data(), a.y.data(), b.x.val, b.y.val, fixed_raw(out), a.size());
+}
+
+/// Clamp each vector to lie inside 'box'.
+template<typename T> static inline void fixp_clamp_n(fixed_vec2_soa<T>& pos, fixed_aabb<T> box)
+{
+	assert(box.min.x <= box.max.x && box.min.y <= box.max.y);
+	fixp_clamp_raw(pos.x.data(), box.min.x.val, box.max.x.val, pos.size());
+	fixp_clamp_raw(pos.y.data(), box.min.y.val, box.max.y.val, pos.size());
+}
+
+void fixp_axpy_n(ivec2_soa& pos, const ivec2_soa& vel, fixp dt);
+void fixp_dot_n(const ivec2_soa& a, const ivec2_soa& b, fixp* out);
+void fixp_length_sq_n(const ivec2_soa& a, fixp* out);
+void fixp_distance_sq_n(const ivec2_soa& a, const ivec2_soa& b, fixp* out);
+void fixp_distance_sq_n(const ivec2_soa& a, ivec2 b, fixp* out);
+void fixp_clamp_n(ivec2_soa& pos, aabb box);
+
+void fixp_axpy_n(ivec2_16_soa& pos, const ivec2_16_soa& vel, fixp16 dt);
+void fixp_dot_n(const ivec2_16_soa& a, const ivec2_16_soa& b, fixp16* out);
+void fixp_length_sq_n(const ivec2_16_soa& a, fixp16* out);
+void fixp_distance_sq_n(const ivec2_16_soa& a, const ivec2_16_soa& b, fixp16* out);
+void fixp_distance_sq_n(const ivec2_16_soa& a, ivec2_16 b, fixp16* out);
+void fixp_clamp_n(ivec2_16_soa& pos, aabb16 box);
@@ -0,0 +1,154 @@
+#include "instrument.h"
+
+#ifdef DICEY_INSTRUMENT
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+static constexpr uint32_t ring_size = 8192; // must be a power of two
+static constexpr uint32_t label_slots = 256; // must be a power of two
+
+struct instrument_event
+{
+	const char* label;
+	uint64_t start;
+	uint64_t end;
+	uint64_t draws;
+};
+
+struct instrument_label
+{
+	const char* label;
+	uint64_t calls;
+	uint64_t ticks;
+	uint64_t draws;
+};
+
+struct instrument_thread
+{
+	uint32_t tid;
+	std::atomic<uint64_t> head; // total events recorded, the ring keeps the last ring_size of them. Published after the event is written.
+	instrument_event events[ring_size];
+	instrument_label labels[label_slots];
+};
+
+// Thread buffers are never freed, so that we can still report on threads that have exited. Neither is the registry, so that they stay
+// reachable at exit and threads may still record during static destruction.
+static std::mutex registry_lock;
+static std::vector<instrument_thread*>& registry = *new std::vector<instrument_thread*>;
+static thread_local instrument_thread* local = nullptr;
+
+static uint64_t now_ns() { struct timespec t; clock_gettime(CLOCK_MONOTONIC, &t); return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec; }
+
+// Reference points to convert ticks to time
+static const uint64_t base_ticks = instrument_ticks();
+static const uint64_t base_ns = now_ns();
+
+static double ns_per_tick()
+{
+	const uint64_t ticks = instrument_ticks() - base_ticks;
+	const uint64_t ns = now_ns() - base_ns;
+	return (ticks > 0) ? (double)ns / ticks : 1.0;
+}
+
+static instrument_thread* register_thread()
+{
+	instrument_thread* t = new instrument_thread(); // value-initialized, so everything starts at zero
+	std::lock_guard<std::mutex> guard(registry_lock);
+	t->tid = registry.size() + 1;
+	registry.push_back(t);
+	return t;
+}
+
+static instrument_label& find_label(instrument_thread* t, const char* label)
+{
+	uint32_t i = (uint32_t)(((uintptr_t)label * 11400714819323198485llu) >> 56) & (label_slots - 1);
+	for (uint32_t probe = 0; probe < label_slots - 1; probe++, i = (i + 1) & (label_slots - 1))
+	{
+		if (t->labels[i].label == label) return t->labels[i];
+		if (!t->labels[i].label) { t->labels[i].label = label; return t->labels[i]; }
+	}
+	instrument_label& overflow = t->labels[label_slots - 1]; // table is full, lump the rest together
+	overflow.label = "(other labels)";
+	return overflow;
+}
+
+void instrument_record(const char* label, uint64_t start, uint64_t end, uint64_t draws)
+{
+	instrument_thread* t = local;
+	if (!t) t = local = register_thread();
+	const uint64_t head = t->head.load(std::memory_order_relaxed); // only this thread writes it
+	t->events[head & (ring_size - 1)] = { label, start, end, draws };
+	t->head.store(head + 1, std::memory_order_release);
+	instrument_label& l = find_label(t, label);
+	l.calls++;
+	l.ticks += end - start;
+	l.draws += draws;
+}
+
+bool instrument_write_trace(const char* path)
+{
+	FILE* fp = fopen(path, "w");
+	if (!fp) return false;
+	const double scale = ns_per_tick() / 1000.0; // Chrome trace wants microseconds
+	std::lock_guard<std::mutex> guard(registry_lock);
+	fprintf(fp, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (const instrument_thread* t : registry)
+	{
+		const uint64_t head = t->head.load(std::memory_order_acquire);
+		const uint64_t count = std::min<uint64_t>(head, ring_size);
+		for (uint64_t i = head - count; i < head; i++)
+		{
+			const instrument_event& e = t->events[i & (ring_size - 1)];
+			fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"draws\":%llu}}",
+			        first ? "" : ",\n", e.label, t->tid, (double)(int64_t)(e.start - base_ticks) * scale, (double)(e.end - e.start) * scale, (unsigned long long)e.draws);
+			first = false;
+		}
+	}
+	fprintf(fp, "\n]}\n");
+	return fclose(fp) == 0;
+}
+
+void instrument_write_table(FILE* fp)
+{
+	std::vector<instrument_label> sum;
+	{
+		std::lock_guard<std::mutex> guard(registry_lock);
+		for (const instrument_thread* t : registry)
+		{
+			for (const instrument_label& l : t->labels)
+			{
+				if (!l.label) continue;
+				auto it = std::find_if(sum.begin(), sum.end(), [&](const instrument_label& s) { return s.label == l.label || strcmp(s.label, l.label) == 0; });
+				if (it == sum.end()) sum.push_back(l);
+				else { it->calls += l.calls; it->ticks += l.ticks; it->draws += l.draws; }
+			}
+		}
+	}
+	std::sort(sum.begin(), sum.end(), [](const instrument_label& a, const instrument_label& b) { return a.ticks > b.ticks; });
+	const double scale = ns_per_tick();
+	fprintf(fp, "%-40s %12s %14s %12s %12s %12s\n", "label", "calls", "draws", "total ms", "ns/call", "draws/call");
+	for (const instrument_label& l : sum)
+	{
+		const double ns = l.ticks * scale;
+		fprintf(fp, "%-40s %12llu %14llu %12.3f %12.1f %12.2f\n", l.label, (unsigned long long)l.calls, (unsigned long long)l.draws, ns / 1e6, ns / l.calls, (double)l.draws / l.calls);
+	}
+}
+
+void instrument_reset()
+{
+	std::lock_guard<std::mutex> guard(registry_lock);
+	for (instrument_thread* t : registry)
+	{
+		t->head.store(0, std::memory_order_relaxed);
+		memset(t->labels, 0, sizeof(t->labels));
+	}
+}
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+// Opt-in instrumentation of PRNG draws and timed scopes. Compile everything with DICEY_INSTRUMENT defined and link instrument.cpp
+// to enable it. Without it, the macros below compile to nothing and xorshift64() is not touched.
+//
+//	DICEY_SCOPE("loot");   // time the rest of this block under the label "loot", and count the draws made in it
+//	DICEY_SCOPE_HERE();    // the same, labelled with the current function name
+//
+// Each thread records its scopes into its own ring buffer, which keeps the most recent events, and into a per-label aggregate that
+// keeps everything. Draws are counted per thread and attributed to every scope that is open when they happen. Labels must be string
+// literals or otherwise live for the rest of the program, since we only keep the pointer.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef DICEY_INSTRUMENT
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t instrument_ticks() { return __rdtsc(); }
+#else
+#include <time.h>
+static inline uint64_t instrument_ticks() { struct timespec t; clock_gettime(CLOCK_MONOTONIC, &t); return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec; }
+#endif
+
+/// Number of PRNG draws made by this thread so far. Take the difference between two frames to get the draws per frame.
+inline thread_local uint64_t instrument_draws = 0;
+
+/// Record one finished scope. Called by instrument_scope below.
+void instrument_record(const char* label, uint64_t start, uint64_t end, uint64_t draws);
+
+struct instrument_scope
+{
+	instrument_scope(const char* _label) : label(_label), start(instrument_ticks()), draws(instrument_draws) {}
+	~instrument_scope() { instrument_record(label, start, instrument_ticks(), instrument_draws - draws); }
+	instrument_scope(const instrument_scope&) = delete;
+
+	const char* label;
+	uint64_t start;
+	uint64_t draws;
+};
+
+#define DICEY_CONCAT2(a, b) a##b
+#define DICEY_CONCAT(a, b) DICEY_CONCAT2(a, b)
+#define DICEY_SCOPE(label) instrument_scope DICEY_CONCAT(dicey_scope_, __LINE__)(label)
+#define DICEY_SCOPE_HERE() instrument_scope DICEY_CONCAT(dicey_scope_, __LINE__)(__func__)
+#define DICEY_COUNT_DRAW() (void)(instrument_draws++)
+
+/// Write the events still in the ring buffers of all threads as Chrome trace JSON, for chrome://tracing or https://ui.perfetto.dev
+/// Returns false if the file could not be written. Do not call this while other threads are inside a scope.
+bool instrument_write_trace(const char* path);
+
+/// Write a table of calls, draws and time per label, summed over all threads, sorted by total time.
+/// Do not call this while other threads are inside a scope.
+void instrument_write_table(FILE* fp);
+
+/// Forget everything recorded so far, in all threads. Do not call this while other threads are inside a scope.
+void instrument_reset();
+
+#else
+
+#define DICEY_SCOPE(label) do {} while (0)
+#define DICEY_SCOPE_HERE() do {} while (0)
+#define DICEY_COUNT_DRAW() do {} while (0)
+
+#endif
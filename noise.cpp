@@ -0,0 +1,146 @@
+#include "noise.h"
+
+#include <vector>
+
+// Q16 noise for a tile, or added to 'acc' with weight 'amp' when that is given.
+static void noise2_tile_q16(uint64_t key, noise_type type, int32_t x0, int32_t y0, int w, int h, int shift, int32_t* out, int64_t* acc = nullptr, int32_t amp = 0)
+{
+	int64_t cx0, cy0, cx1, cy1; int32_t f;
+	noise_split(x0, shift, cx0, f);
+	noise_split(y0, shift, cy0, f);
+	noise_split((int64_t)x0 + w - 1, shift, cx1, f);
+	noise_split((int64_t)y0 + h - 1, shift, cy1, f);
+	const int lw = cx1 - cx0 + 2; // lattice points spanned by the tile
+	const int lh = cy1 - cy0 + 2;
+
+	// Hash the lattice just like seed::derive(x, y) does, a whole row at a time
+	std::vector<uint64_t> in(lw), hx(lw), hxy(lw), lattice((size_t)lw * lh);
+	for (int i = 0; i < lw; i++) in[i] = cx0 + i;
+	splitmix64_n(in.data(), hx.data(), lw);
+	for (int j = 0; j < lh; j++)
+	{
+		for (int i = 0; i < lw; i++) in[i] = (uint64_t)(cx0 + i) + (uint64_t)(cy0 + j);
+		splitmix64_n(in.data(), hxy.data(), lw);
+		uint64_t* row = &lattice[(size_t)j * lw];
+		for (int i = 0; i < lw; i++) row[i] = key ^ (fibonacci * hx[i] * hxy[i]);
+	}
+
+	std::vector<int32_t> cell_x(w), frac_x(w), fade_x(w);
+	for (int i = 0; i < w; i++)
+	{
+		int64_t c;
+		noise_split((int64_t)x0 + i, shift, c, frac_x[i]);
+		cell_x[i] = c - cx0;
+		fade_x[i] = noise_fade(frac_x[i]);
+	}
+	for (int j = 0; j < h; j++)
+	{
+		int64_t c; int32_t fy;
+		noise_split((int64_t)y0 + j, shift, c, fy);
+		const int32_t v = noise_fade(fy);
+		const uint64_t* r0 = &lattice[(size_t)(c - cy0) * lw];
+		const uint64_t* r1 = r0 + lw;
+		for (int i = 0; i < w; i++)
+		{
+			const int ci = cell_x[i];
+			const int32_t fx = frac_x[i];
+			const int32_t u = fade_x[i];
+			int32_t n;
+			if (type == noise_type::value)
+			{
+				n = noise_lerp(noise_lerp(noise_value(r0[ci]), noise_value(r0[ci + 1]), u), noise_lerp(noise_value(r1[ci]), noise_value(r1[ci + 1]), u), v);
+			}
+			else
+			{
+				n = noise_lerp(noise_lerp(noise_grad(r0[ci], fx, fy), noise_grad(r0[ci + 1], fx - 65536, fy), u),
+				               noise_lerp(noise_grad(r1[ci], fx, fy - 65536), noise_grad(r1[ci + 1], fx - 65536, fy - 65536), u), v);
+			}
+			if (acc) acc[(size_t)j * w + i] += (int64_t)n * amp;
+			else out[(size_t)j * w + i] = n;
+		}
+	}
+}
+
+void noise2_tile(const seed& s, noise_type type, int32_t x0, int32_t y0, int w, int h, int shift, int16_t* out)
+{
+	assert(w > 0 && h > 0);
+	std::vector<int32_t> q16((size_t)w * h);
+	noise2_tile_q16(noise_key(s), type, x0, y0, w, h, shift, q16.data());
+	for (size_t i = 0; i < q16.size(); i++) out[i] = noise_to_int16(q16[i]);
+}
+
+void fbm2_tile(const seed& s, noise_type type, int32_t x0, int32_t y0, int w, int h, int shift, int octaves, int16_t* out, int32_t gain)
+{
+	assert(w > 0 && h > 0);
+	assert(octaves >= 1 && octaves <= shift + 1);
+	std::vector<int64_t> sum((size_t)w * h, 0);
+	int64_t total = 0;
+	for (int i = 0; i < octaves; i++)
+	{
+		const int32_t amp = noise_amplitude(i, gain);
+		noise2_tile_q16(noise_key(s, i), type, x0, y0, w, h, shift - i, nullptr, sum.data(), amp);
+		total += amp;
+	}
+	total = std::max<int64_t>(total, 1);
+	for (size_t i = 0; i < sum.size(); i++) out[i] = noise_to_int16(sum[i] / total);
+}
+
+namespace
+{
+	struct blue_noise_candidate
+	{
+		int64_t x, y; // in Q24 cell units
+		uint64_t priority;
+	};
+}
+
+static inline blue_noise_candidate blue_noise_cell(uint64_t key, int64_t gx, int64_t gy)
+{
+	const uint64_t h = noise_hash(key, gx, gy);
+	return { (gx << 24) + (int64_t)(h >> 40), (gy << 24) + (int64_t)((h >> 16) & 0xffffff), splitmix64(h) };
+}
+
+// Equal priorities are broken by position, so that the order is total and the result does not depend on which chunk we are in.
+static inline bool blue_noise_beats(const blue_noise_candidate& a, const blue_noise_candidate& b)
+{
+	return a.priority > b.priority || (a.priority == b.priority && (a.y < b.y || (a.y == b.y && a.x < b.x)));
+}
+
+int blue_noise_chunk(const seed& s, int32_t chunk_x, int32_t chunk_y, int cells, fixp radius, ivec2* out)
+{
+	assert(cells > 0);
+	assert(radius.val > 0 && radius.val < (1ll << 38));
+	const uint64_t key = noise_key(s);
+	const int64_t gx0 = (int64_t)chunk_x * cells;
+	const int64_t gy0 = (int64_t)chunk_y * cells;
+	int count = 0;
+	for (int64_t gy = gy0; gy < gy0 + cells; gy++)
+	{
+		blue_noise_candidate window[3][3]; // [column][row] of the candidates around the current cell, slid along the row
+		for (int i = 0; i < 2; i++) for (int j = 0; j < 3; j++) window[i + 1][j] = blue_noise_cell(key, gx0 - 1 + i, gy - 1 + j);
+		for (int64_t gx = gx0; gx < gx0 + cells; gx++)
+		{
+			window[0][0] = window[1][0]; window[0][1] = window[1][1]; window[0][2] = window[1][2];
+			window[1][0] = window[2][0]; window[1][1] = window[2][1]; window[1][2] = window[2][2];
+			for (int j = 0; j < 3; j++) window[2][j] = blue_noise_cell(key, gx + 1, gy - 1 + j);
+			const blue_noise_candidate& c = window[1][1];
+			bool keep = true;
+			for (int i = 0; i < 3 && keep; i++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					if (i == 1 && j == 1) continue;
+					const blue_noise_candidate& o = window[i][j];
+					const int64_t dx = o.x - c.x;
+					const int64_t dy = o.y - c.y;
+					if (dx * dx + dy * dy < (1ll << 48) && blue_noise_beats(o, c)) { keep = false; break; }
+				}
+			}
+			if (!keep) continue;
+			out[count].x.val = (c.x >> 24) * radius.val + (((c.x & 0xffffff) * radius.val) >> 24);
+			out[count].y.val = (c.y >> 24) * radius.val + (((c.y & 0xffffff) * radius.val) >> 24);
+			count++;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+// Deterministic integer value and gradient noise in 2D and 3D, with fractal octaves (fBm).
+//
+// All of it is integer math, so results are bit-identical on every platform and compiler, and client and server can generate the same terrain.
+// Lattice points are hashed exactly like seed::derive(), so the hash of lattice point (x, y) is s.derive(x, y).orig.
+//
+// Positions are integer coordinates with a cell size of 2^shift, or fixp with a cell size of 1.0. Noise is returned as int16_t in [-32768, 32767]
+// or as fixp in [-1, 1]. Gradient noise is zero on the lattice points themselves, so it needs a shift of at least a few bits to be of any use.
+
+#include "dice.h"
+#include "fixp.h"
+
+enum class noise_type
+{
+	value,		// smoothly interpolated random values at the lattice points
+	gradient,	// Perlin style, interpolated random gradients at the lattice points
+};
+
+// -- Building blocks --
+// Internally noise is Q16, where 65536 is 1.0
+
+/// Hash of a 2D lattice point, the same as `s.derive(x, y).orig` for key = splitmix64(s.orig).
+static inline uint64_t noise_hash(uint64_t key, int64_t x, int64_t y) { return key ^ (fibonacci * splitmix64(x) * splitmix64((uint64_t)x + y)); }
+/// Hash of a 3D lattice point, the same as `s.derive(x, y, z).orig` for key = splitmix64(s.orig).
+static inline uint64_t noise_hash(uint64_t key, int64_t x, int64_t y, int64_t z) { return key ^ (fibonacci * splitmix64(x) * splitmix64((uint64_t)x + y) * splitmix64((uint64_t)x + y + z)); }
+
+/// The hash key for octave 'octave' of fBm.
+static inline uint64_t noise_key(const seed& s, int octave = 0) { return splitmix64(octave == 0 ? s.orig : s.derive(octave).orig); }
+
+/// Split a position into its cell and the Q16 fraction within that cell, for a cell size of 2^shift.
+static inline void noise_split(int64_t p, int shift, int64_t& cell, int32_t& frac)
+{
+	assert(shift >= 0 && shift < 63);
+	cell = p >> shift;
+	const uint64_t f = p & ((1ull << shift) - 1);
+	frac = (shift >= 16) ? f >> (shift - 16) : f << (16 - shift);
+}
+
+/// Quintic fade curve t^3 (6t^2 - 15t + 10), in Q16. This is the exact floor, so the curve never steps backwards, and the product is split
+/// in two so that it does not overflow 64 bits.
+static inline int32_t noise_fade(int32_t t)
+{
+	assert(t >= 0 && t <= 65536);
+	const uint64_t t3 = (uint64_t)t * t * t; // Q48
+	const uint64_t poly = 6 * (uint64_t)t * t - 15 * 65536 * (uint64_t)t + (10ull << 32); // Q32, always positive
+	return ((t3 >> 24) * poly + (((t3 & 0xffffff) * poly) >> 24)) >> 40; // Q80 down to Q16
+}
+
+static inline int32_t noise_lerp(int32_t a, int32_t b, int32_t t) { return a + (int32_t)(((int64_t)(b - a) * t) >> 16); }
+
+/// Random lattice value in [-65536, 65535].
+static inline int32_t noise_value(uint64_t h) { return (int32_t)(h >> 47) - 65536; }
+
+/// Dot product of one of the four diagonal gradients with the offset (dx, dy).
+static inline int32_t noise_grad(uint64_t h, int32_t dx, int32_t dy) { return ((h >> 63) ? -dx : dx) + (((h >> 62) & 1) ? -dy : dy); }
+
+/// Dot product of one of the twelve cube edge gradients with the offset (dx, dy, dz).
+static inline int32_t noise_grad(uint64_t h, int32_t dx, int32_t dy, int32_t dz)
+{
+	static constexpr int8_t g[12][3] = { { 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 }, { 1, 0, 1 }, { -1, 0, 1 },
+	                                     { 1, 0, -1 }, { -1, 0, -1 }, { 0, 1, 1 }, { 0, -1, 1 }, { 0, 1, -1 }, { 0, -1, -1 } };
+	const int8_t* v = g[((h >> 32) * 12) >> 32];
+	return v[0] * dx + v[1] * dy + v[2] * dz;
+}
+
+/// Q16 noise at Q16 fraction (fx, fy) of lattice cell (cx, cy).
+static inline int32_t noise2_q16(noise_type type, uint64_t key, int64_t cx, int64_t cy, int32_t fx, int32_t fy)
+{
+	const uint64_t h00 = noise_hash(key, cx, cy), h10 = noise_hash(key, cx + 1, cy);
+	const uint64_t h01 = noise_hash(key, cx, cy + 1), h11 = noise_hash(key, cx + 1, cy + 1);
+	const int32_t u = noise_fade(fx);
+	const int32_t v = noise_fade(fy);
+	if (type == noise_type::value)
+	{
+		return noise_lerp(noise_lerp(noise_value(h00), noise_value(h10), u), noise_lerp(noise_value(h01), noise_value(h11), u), v);
+	}
+	return noise_lerp(noise_lerp(noise_grad(h00, fx, fy), noise_grad(h10, fx - 65536, fy), u),
+	                  noise_lerp(noise_grad(h01, fx, fy - 65536), noise_grad(h11, fx - 65536, fy - 65536), u), v);
+}
+
+/// Q16 noise at Q16 fraction (fx, fy, fz) of lattice cell (cx, cy, cz).
+static inline int32_t noise3_q16(noise_type type, uint64_t key, int64_t cx, int64_t cy, int64_t cz, int32_t fx, int32_t fy, int32_t fz)
+{
+	const int32_t u = noise_fade(fx);
+	const int32_t v = noise_fade(fy);
+	const int32_t w = noise_fade(fz);
+	int32_t plane[2];
+	for (int k = 0; k < 2; k++)
+	{
+		const uint64_t h00 = noise_hash(key, cx, cy, cz + k), h10 = noise_hash(key, cx + 1, cy, cz + k);
+		const uint64_t h01 = noise_hash(key, cx, cy + 1, cz + k), h11 = noise_hash(key, cx + 1, cy + 1, cz + k);
+		if (type == noise_type::value)
+		{
+			plane[k] = noise_lerp(noise_lerp(noise_value(h00), noise_value(h10), u), noise_lerp(noise_value(h01), noise_value(h11), u), v);
+		}
+		else
+		{
+			const int32_t dz = fz - k * 65536;
+			plane[k] = noise_lerp(noise_lerp(noise_grad(h00, fx, fy, dz), noise_grad(h10, fx - 65536, fy, dz), u),
+			                      noise_lerp(noise_grad(h01, fx, fy - 65536, dz), noise_grad(h11, fx - 65536, fy - 65536, dz), u), v);
+		}
+	}
+	return noise_lerp(plane[0], plane[1], w);
+}
+
+static inline int32_t noise2_at(noise_type type, uint64_t key, int64_t x, int64_t y, int shift)
+{
+	int64_t cx, cy; int32_t fx, fy;
+	noise_split(x, shift, cx, fx);
+	noise_split(y, shift, cy, fy);
+	return noise2_q16(type, key, cx, cy, fx, fy);
+}
+
+static inline int32_t noise3_at(noise_type type, uint64_t key, int64_t x, int64_t y, int64_t z, int shift)
+{
+	int64_t cx, cy, cz; int32_t fx, fy, fz;
+	noise_split(x, shift, cx, fx);
+	noise_split(y, shift, cy, fy);
+	noise_split(z, shift, cz, fz);
+	return noise3_q16(type, key, cx, cy, cz, fx, fy, fz);
+}
+
+/// Octave weights of fBm. Each octave has twice the frequency of the one before and 'gain' (Q16) times its amplitude.
+static inline int32_t noise_amplitude(int octave, int32_t gain) { int64_t a = 65536; for (int i = 0; i < octave; i++) a = (a * gain) >> 16; return a; }
+
+/// Q16 fBm, the amplitude weighted average of 'octaves' octaves, starting with a cell size of 2^shift.
+static inline int32_t fbm2_at(noise_type type, const seed& s, int64_t x, int64_t y, int shift, int octaves, int32_t gain)
+{
+	assert(octaves >= 1 && octaves <= shift + 1);
+	int64_t sum = 0, total = 0;
+	for (int i = 0; i < octaves; i++)
+	{
+		const int32_t amp = noise_amplitude(i, gain);
+		sum += (int64_t)noise2_at(type, noise_key(s, i), x, y, shift - i) * amp;
+		total += amp;
+	}
+	return sum / std::max<int64_t>(total, 1);
+}
+
+static inline int32_t fbm3_at(noise_type type, const seed& s, int64_t x, int64_t y, int64_t z, int shift, int octaves, int32_t gain)
+{
+	assert(octaves >= 1 && octaves <= shift + 1);
+	int64_t sum = 0, total = 0;
+	for (int i = 0; i < octaves; i++)
+	{
+		const int32_t amp = noise_amplitude(i, gain);
+		sum += (int64_t)noise3_at(type, noise_key(s, i), x, y, z, shift - i) * amp;
+		total += amp;
+	}
+	return sum / std::max<int64_t>(total, 1);
+}
+
+static inline int16_t noise_to_int16(int32_t q16) { return std::clamp(q16 >> 1, -32768, 32767); }
+static inline fixp noise_to_fixp(int32_t q16) { fixp r; r.val = (int64_t)std::clamp(q16, -65536, 65536) << (fraction_bits - 16); return r; }
+
+// -- Noise --
+
+/// Noise at integer position (x, y) with a cell size of 2^shift, where 'shift' is 0 to 31.
+static inline int16_t value_noise2(const seed& s, int32_t x, int32_t y, int shift) { return noise_to_int16(noise2_at(noise_type::value, noise_key(s), x, y, shift)); }
+static inline int16_t gradient_noise2(const seed& s, int32_t x, int32_t y, int shift) { return noise_to_int16(noise2_at(noise_type::gradient, noise_key(s), x, y, shift)); }
+static inline int16_t value_noise3(const seed& s, int32_t x, int32_t y, int32_t z, int shift) { return noise_to_int16(noise3_at(noise_type::value, noise_key(s), x, y, z, shift)); }
+static inline int16_t gradient_noise3(const seed& s, int32_t x, int32_t y, int32_t z, int shift) { return noise_to_int16(noise3_at(noise_type::gradient, noise_key(s), x, y, z, shift)); }
+
+/// Noise at a fixp position with a cell size of 1.0.
+static inline fixp value_noise2(const seed& s, fixp x, fixp y) { return noise_to_fixp(noise2_at(noise_type::value, noise_key(s), x.val, y.val, fraction_bits)); }
+static inline fixp gradient_noise2(const seed& s, fixp x, fixp y) { return noise_to_fixp(noise2_at(noise_type::gradient, noise_key(s), x.val, y.val, fraction_bits)); }
+static inline fixp value_noise3(const seed& s, fixp x, fixp y, fixp z) { return noise_to_fixp(noise3_at(noise_type::value, noise_key(s), x.val, y.val, z.val, fraction_bits)); }
+static inline fixp gradient_noise3(const seed& s, fixp x, fixp y, fixp z) { return noise_to_fixp(noise3_at(noise_type::gradient, noise_key(s), x.val, y.val, z.val, fraction_bits)); }
+
+/// Fractal noise. The first octave has a cell size of 2^shift, and each next octave halves the cell size and multiplies the amplitude by 'gain'
+/// (Q16, so 32768 is 0.5). 'octaves' can be at most shift + 1. The result is normalized by the sum of the amplitudes.
+static inline int16_t fbm2(const seed& s, int32_t x, int32_t y, int shift, int octaves, noise_type type = noise_type::gradient, int32_t gain = 32768) { return noise_to_int16(fbm2_at(type, s, x, y, shift, octaves, gain)); }
+static inline int16_t fbm3(const seed& s, int32_t x, int32_t y, int32_t z, int shift, int octaves, noise_type type = noise_type::gradient, int32_t gain = 32768) { return noise_to_int16(fbm3_at(type, s, x, y, z, shift, octaves, gain)); }
+static inline fixp fbm2(const seed& s, fixp x, fixp y, int octaves, noise_type type = noise_type::gradient, int32_t gain = 32768) { return noise_to_fixp(fbm2_at(type, s, x.val, y.val, fraction_bits, octaves, gain)); }
+static inline fixp fbm3(const seed& s, fixp x, fixp y, fixp z, int octaves, noise_type type = noise_type::gradient, int32_t gain = 32768) { return noise_to_fixp(fbm3_at(type, s, x.val, y.val, z.val, fraction_bits, octaves, gain)); }
+
+// -- Tiles --
+// These give exactly the same results as calling the functions above for each position, but hash each lattice point of the tile only once,
+// using splitmix64_n() on whole lattice rows, and share the fade curve between pixels of the same column and row. A row is a tile with h = 1.
+
+/// Fill the 'w' by 'h' tile starting at (x0, y0) with noise, row by row, into 'out'.
+void noise2_tile(const seed& s, noise_type type, int32_t x0, int32_t y0, int w, int h, int shift, int16_t* out);
+
+/// Fill the 'w' by 'h' tile starting at (x0, y0) with fBm, row by row, into 'out'.
+void fbm2_tile(const seed& s, noise_type type, int32_t x0, int32_t y0, int w, int h, int shift, int octaves, int16_t* out, int32_t gain = 32768);
+
+// -- Blue noise --
+
+/// Well separated random points for the chunk (chunk_x, chunk_y), in world fixp coordinates. The world is divided into square cells with sides
+/// of 'radius', and a chunk is 'cells' by 'cells' of them, starting at the world origin. Each cell holds one candidate point, jittered by its
+/// s.derive(x, y) hash and given a random priority, and a candidate is kept only if no other candidate closer than 'radius' has a higher
+/// priority (Matérn type II thinning). So no two points are ever closer than 'radius', about a third of the cells get a point, and since the rule
+/// only looks at the cells around each candidate, every point is the same no matter which chunk asks for it, and chunks join without seams.
+/// It takes O(cells^2) time and no heap memory. 'out' must have room for cells * cells points. Returns the number of points.
+int blue_noise_chunk(const seed& s, int32_t chunk_x, int32_t chunk_y, int cells, fixp radius, ivec2* out);
@@ -0,0 +1,298 @@
+#pragma once
+
+// Small microbenchmark runner for the perf_* programs. Register benchmarks with BENCH(name) and loop over the state:
+//
+//	BENCH(roll) { seed s(1); uint64_t sum = 0; for (auto _ : state) sum += s.roll(0, 100); bench_keep(sum); }
+//	BENCH_MAIN()
+//
+// Setup before the loop is not timed. Each benchmark is warmed up while its iteration count is grown until one sample takes long
+// enough to measure, then sampled repeatedly. We report the median and 99th percentile time per iteration, and items per second
+// where an iteration does more than one item (see bench_state::items). Options:
+//
+//	--filter=text   only run benchmarks whose name contains 'text'
+//	--json=file     also write the results as JSON
+//	--csv=file      also write the results as CSV
+//	--samples=n     number of timed samples per benchmark (default 15)
+//	--min-ns=n      minimum time for one sample in nanoseconds (default 1000000)
+//	--counters      also read hardware performance counters around the timed loops (Linux only), and report them per iteration
+//
+// The counters are cycles, instructions, branch misses, L1 data cache read misses and last level cache misses. Any of them that cannot
+// be opened, for example in a container or with a strict perf_event_paranoid setting, are reported as -1 and the run goes on without them.
+
+#include "dmath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// Keep the compiler from optimizing away a value.
+template<typename T> static inline void bench_keep(const T& value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+enum bench_counter { bench_cycles, bench_instructions, bench_branch_misses, bench_l1d_misses, bench_llc_misses, bench_counter_count };
+
+static const char* const bench_counter_names[bench_counter_count] = { "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses" };
+
+/// Hardware performance counters, counting only this thread in user space.
+struct bench_counters
+{
+	int fd[bench_counter_count];
+
+	bench_counters()
+	{
+		for (int& f : fd) f = -1;
+#ifdef __linux__
+		const uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		const uint32_t types[bench_counter_count] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE };
+		const uint64_t configs[bench_counter_count] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, l1d_read_miss, PERF_COUNT_HW_CACHE_MISSES };
+		for (int i = 0; i < bench_counter_count; i++)
+		{
+			struct perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = types[i];
+			attr.config = configs[i];
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		}
+#endif
+	}
+	bench_counters(const bench_counters&) = delete;
+	~bench_counters() { close_all(); }
+
+	bool any() const { for (int f : fd) if (f >= 0) return true; return false; }
+
+	inline void start()
+	{
+#ifdef __linux__
+		for (int f : fd) if (f >= 0) { ioctl(f, PERF_EVENT_IOC_RESET, 0); ioctl(f, PERF_EVENT_IOC_ENABLE, 0); }
+#endif
+	}
+
+	inline void stop()
+	{
+#ifdef __linux__
+		for (int f : fd) if (f >= 0) ioctl(f, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+	}
+
+	/// Add the counts since start() to 'totals'
+	void read_into(int64_t* totals)
+	{
+#ifdef __linux__
+		for (int i = 0; i < bench_counter_count; i++)
+		{
+			uint64_t value = 0;
+			if (fd[i] >= 0 && read(fd[i], &value, sizeof(value)) == sizeof(value)) totals[i] += value;
+		}
+#endif
+	}
+
+private:
+	void close_all()
+	{
+#ifdef __linux__
+		for (int& f : fd) if (f >= 0) { close(f); f = -1; }
+#endif
+	}
+};
+
+struct bench_state
+{
+	/// What the loop variable in 'for (auto _ : state)' gets. An empty type, so that leaving it unused does not warn.
+	struct [[maybe_unused]] unused {};
+
+	struct iterator
+	{
+		bench_state* state;
+		uint64_t left;
+		inline bool operator!=(const iterator&) { if (dicey_likely(left > 0)) return true; state->stop = cpu_gettime(); if (state->counters) state->counters->stop(); return false; }
+		inline void operator++() { left--; }
+		inline unused operator*() const { return unused{}; }
+	};
+
+	inline iterator begin() { if (counters) counters->start(); start = cpu_gettime(); return iterator{ this, iterations }; }
+	inline iterator end() { return iterator{ this, 0 }; }
+
+	/// Number of items (for example rolls) that one iteration processes, for the items per second column.
+	uint64_t items = 1;
+	uint64_t iterations = 0;
+	uint64_t start = 0;
+	uint64_t stop = 0;
+	bench_counters* counters = nullptr;
+};
+
+typedef void (*bench_func)(bench_state& state);
+
+struct bench_result
+{
+	std::string name;
+	uint64_t iterations;
+	int samples;
+	double median_ns; // per iteration
+	double p99_ns; // per iteration
+	double min_ns; // per iteration
+	double items_per_sec;
+	double counters[bench_counter_count]; // per iteration, or -1 if not available
+};
+
+struct bench_entry
+{
+	const char* name;
+	bench_func func;
+};
+
+static inline std::vector<bench_entry>& bench_registry() { static std::vector<bench_entry> list; return list; }
+
+struct bench_register
+{
+	bench_register(const char* name, bench_func func) { bench_registry().push_back({ name, func }); }
+};
+
+#define BENCH(name) \
+	static void bench_##name(bench_state& state); \
+	static bench_register bench_register_##name(#name, bench_##name); \
+	static void bench_##name(bench_state& state)
+
+#define BENCH_MAIN() int main(int argc, char **argv) { return bench_main(argc, argv); }
+
+/// Run one sample with the given iteration count, and return its time in nanoseconds.
+static inline uint64_t bench_sample(bench_func func, uint64_t iterations, uint64_t& items, bench_counters* counters = nullptr)
+{
+	bench_state state;
+	state.iterations = iterations;
+	state.counters = counters;
+	func(state);
+	items = state.items;
+	return (state.stop >= state.start) ? state.stop - state.start : 0;
+}
+
+static inline bench_result bench_run(const bench_entry& entry, int samples, uint64_t min_ns, bench_counters* counters)
+{
+	uint64_t items = 1;
+	uint64_t iterations = 1;
+	// Warmup, growing the iteration count until one sample takes long enough
+	for (;;)
+	{
+		const uint64_t t = bench_sample(entry.func, iterations, items);
+		if (t >= min_ns || iterations >= (1ull << 40)) break;
+		const uint64_t grow = (t > 0) ? (min_ns * 3 / 2) / t : 100;
+		iterations *= std::clamp<uint64_t>(grow, 2, 100);
+	}
+	std::vector<double> per_op(samples);
+	int64_t totals[bench_counter_count] = {};
+	for (int i = 0; i < samples; i++)
+	{
+		per_op[i] = (double)bench_sample(entry.func, iterations, items, counters) / iterations;
+		if (counters) counters->read_into(totals);
+	}
+	std::sort(per_op.begin(), per_op.end());
+	bench_result r;
+	r.name = entry.name;
+	r.iterations = iterations;
+	r.samples = samples;
+	r.median_ns = (samples % 2) ? per_op[samples / 2] : (per_op[samples / 2 - 1] + per_op[samples / 2]) / 2;
+	r.p99_ns = per_op[std::min<int>(samples - 1, (samples * 99 + 99) / 100 - 1)]; // nearest rank
+	r.min_ns = per_op[0];
+	r.items_per_sec = (r.median_ns > 0) ? items * 1e9 / r.median_ns : 0;
+	for (int i = 0; i < bench_counter_count; i++) r.counters[i] = (counters && counters->fd[i] >= 0) ? (double)totals[i] / ((double)iterations * samples) : -1;
+	return r;
+}
+
+static inline void bench_write_json(const char* path, const std::vector<bench_result>& results)
+{
+	FILE* fp = fopen(path, "w");
+	if (!fp) { fprintf(stderr, "Cannot open %s\n", path); return; }
+	fprintf(fp, "{\n\t\"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const bench_result& r = results[i];
+		fprintf(fp, "\t\t{ \"name\": \"%s\", \"iterations\": %" PRIu64 ", \"samples\": %d, \"median_ns\": %.3f, \"p99_ns\": %.3f, \"min_ns\": %.3f, \"items_per_sec\": %.1f",
+		        r.name.c_str(), r.iterations, r.samples, r.median_ns, r.p99_ns, r.min_ns, r.items_per_sec);
+		for (int c = 0; c < bench_counter_count; c++) fprintf(fp, ", \"%s\": %.3f", bench_counter_names[c], r.counters[c]);
+		fprintf(fp, " }%s\n", (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(fp, "\t]\n}\n");
+	fclose(fp);
+}
+
+static inline void bench_write_csv(const char* path, const std::vector<bench_result>& results)
+{
+	FILE* fp = fopen(path, "w");
+	if (!fp) { fprintf(stderr, "Cannot open %s\n", path); return; }
+	fprintf(fp, "name,iterations,samples,median_ns,p99_ns,min_ns,items_per_sec");
+	for (int c = 0; c < bench_counter_count; c++) fprintf(fp, ",%s", bench_counter_names[c]);
+	fprintf(fp, "\n");
+	for (const bench_result& r : results)
+	{
+		fprintf(fp, "%s,%" PRIu64 ",%d,%.3f,%.3f,%.3f,%.1f", r.name.c_str(), r.iterations, r.samples, r.median_ns, r.p99_ns, r.min_ns, r.items_per_sec);
+		for (int c = 0; c < bench_counter_count; c++) fprintf(fp, ",%.3f", r.counters[c]);
+		fprintf(fp, "\n");
+	}
+	fclose(fp);
+}
+
+static inline int bench_main(int argc, char **argv)
+{
+	const char* filter = nullptr;
+	const char* json = nullptr;
+	const char* csv = nullptr;
+	int samples = 15;
+	uint64_t min_ns = 1000000;
+	bool use_counters = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strncmp(argv[i], "--filter=", 9) == 0) filter = argv[i] + 9;
+		else if (strncmp(argv[i], "--json=", 7) == 0) json = argv[i] + 7;
+		else if (strncmp(argv[i], "--csv=", 6) == 0) csv = argv[i] + 6;
+		else if (strncmp(argv[i], "--samples=", 10) == 0) samples = std::max(1, atoi(argv[i] + 10));
+		else if (strncmp(argv[i], "--min-ns=", 9) == 0) min_ns = strtoull(argv[i] + 9, nullptr, 10);
+		else if (strcmp(argv[i], "--counters") == 0) use_counters = true;
+		else { fprintf(stderr, "Unknown option %s\n", argv[i]); return 1; }
+	}
+	bench_counters* counters = nullptr;
+	if (use_counters)
+	{
+		counters = new bench_counters;
+		if (!counters->any())
+		{
+			printf("Hardware performance counters are not available here, see /proc/sys/kernel/perf_event_paranoid\n");
+			delete counters;
+			counters = nullptr;
+		}
+	}
+	std::vector<bench_result> results;
+	printf("%-40s %12s %12s %12s %14s", "benchmark", "iterations", "median ns", "p99 ns", "items/sec");
+	if (counters) printf(" %10s %10s %6s %10s %10s %10s", "cycles", "instr", "IPC", "br-miss", "L1d-miss", "LLC-miss");
+	printf("\n");
+	for (const bench_entry& entry : bench_registry())
+	{
+		if (filter && !strstr(entry.name, filter)) continue;
+		const bench_result r = bench_run(entry, samples, min_ns, counters);
+		printf("%-40s %12" PRIu64 " %12.2f %12.2f %14.0f", r.name.c_str(), r.iterations, r.median_ns, r.p99_ns, r.items_per_sec);
+		if (counters)
+		{
+			const double* c = r.counters;
+			const double ipc = (c[bench_cycles] > 0 && c[bench_instructions] >= 0) ? c[bench_instructions] / c[bench_cycles] : -1;
+			printf(" %10.2f %10.2f %6.2f %10.3f %10.3f %10.3f", c[bench_cycles], c[bench_instructions], ipc, c[bench_branch_misses], c[bench_l1d_misses], c[bench_llc_misses]);
+		}
+		printf("\n");
+		results.push_back(r);
+	}
+	delete counters;
+	if (json) bench_write_json(json, results);
+	if (csv) bench_write_csv(csv, results);
+	return 0;
+}
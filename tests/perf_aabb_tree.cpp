@@ -0,0 +1,90 @@
+#include "aabb_tree.h"
+#include "bench.h"
+
+static const int count = 4000;
+static const int queries = 20;
+
+// Entities one unit across in a world of 640 by 640 units
+static std::vector<aabb> make()
+{
+	std::vector<aabb> boxes;
+	uint64_t state = 1;
+	for (int i = 0; i < count; i++)
+	{
+		const ivec2 p = { fixp((int)(xorshift64(state) % 640)), fixp((int)(xorshift64(state) % 640)) };
+		boxes.push_back(aabb{ p, { p.x + 1, p.y + 1 } });
+	}
+	return boxes;
+}
+
+// aggro radius checks around a few entities by testing all of them
+BENCH(radius_brute_force_4k)
+{
+	const std::vector<aabb> boxes = make();
+	state.items = queries;
+	for (auto _ : state)
+	{
+		size_t hits = 0;
+		for (int q = 0; q < queries; q++)
+		{
+			const ivec2 c = boxes[q].min;
+			for (const aabb& b : boxes) hits += aabb_tree::distance_sq(b, c) <= (__int128)fixp(20).val * fixp(20).val;
+		}
+		bench_keep(hits);
+	}
+}
+
+// and with the tree
+BENCH(radius_tree_4k)
+{
+	const std::vector<aabb> boxes = make();
+	aabb_tree tree(fixp(1) / 4);
+	for (int i = 0; i < count; i++) tree.insert(boxes[i], i);
+	state.items = queries;
+	for (auto _ : state)
+	{
+		size_t hits = 0;
+		for (int q = 0; q < queries; q++) tree.query_radius(boxes[q].min, fixp(20), [&](int32_t) { hits++; return true; });
+		bench_keep(hits);
+	}
+}
+
+BENCH(raycast_tree_4k)
+{
+	const std::vector<aabb> boxes = make();
+	aabb_tree tree(fixp(1) / 4);
+	for (int i = 0; i < count; i++) tree.insert(boxes[i], i);
+	uint64_t rng = 3;
+	state.items = queries;
+	for (auto _ : state)
+	{
+		int32_t hits = 0;
+		fixp t;
+		for (int q = 0; q < queries; q++) hits += tree.raycast(boxes[q].min, ivec2{ fixp((int)(xorshift64(rng) % 640)), fixp((int)(xorshift64(rng) % 640)) }, t);
+		bench_keep(hits);
+	}
+}
+
+// every entity moves a little each frame
+BENCH(move_tree_4k)
+{
+	std::vector<aabb> boxes = make();
+	aabb_tree tree(fixp(1) / 4);
+	std::vector<int32_t> ids;
+	for (int i = 0; i < count; i++) ids.push_back(tree.insert(boxes[i], i));
+	uint64_t rng = 5;
+	state.items = count;
+	for (auto _ : state)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const fixp d = fixp((int)(xorshift64(rng) % 3) - 1) / 16;
+			boxes[i].min.x += d;
+			boxes[i].max.x += d;
+			tree.move(ids[i], boxes[i]);
+		}
+		bench_keep(tree.height());
+	}
+}
+
+BENCH_MAIN()
@@ -1,19 +1,22 @@
 #include "dice.h"
-#include <assert.h>
-#include <stdio.h>
+#include "bench.h"
 
-// test performance of the roll table rolls() call
-int main(int argc, char **argv)
+// test performance of the roll table boxgacha() call, drawing a whole table empty
+BENCH(boxgacha_10k)
 {
-	seed s = seed_random();
-	uint64_t sum = 0;
-	const int num = 50000;
+	seed s(1);
+	const int num = 10000;
 	std::vector<int> t(num);
 	for (int i = 1; i < num; i++) t[i] = i / num + 1;
-	roll_table rt(s, t);
-	for (int i = 1; i < num; i++)
+	const roll_table full(s, t);
+	state.items = num - 1;
+	uint64_t sum = 0;
+	for (auto _ : state)
 	{
-		sum += rt.boxgacha(luck_type::normal, 0);
+		roll_table rt = full;
+		for (int i = 1; i < num; i++) sum += rt.boxgacha(luck_type::normal, 0);
 	}
-	return (int)sum * 0;
+	bench_keep(sum);
 }
+
+BENCH_MAIN()
@@ -0,0 +1,88 @@
+#include "broadphase.h"
+#include "bench.h"
+
+static const size_t count = 1024;
+
+// Boxes of up to four units across in a world of 512 by 512 units
+static aabb_soa make()
+{
+	aabb_soa boxes;
+	uint64_t state = 1;
+	for (size_t i = 0; i < count; i++)
+	{
+		aabb b;
+		b.min.x = fixp((int)(xorshift64(state) % 512));
+		b.min.y = fixp((int)(xorshift64(state) % 512));
+		b.max.x = b.min.x + fixp((int)(xorshift64(state) % 5));
+		b.max.y = b.min.y + fixp((int)(xorshift64(state) % 5));
+		boxes.push_back(b);
+	}
+	return boxes;
+}
+
+// all pairs, one at a time with fixp_overlaps
+BENCH(all_pairs_scalar_1k)
+{
+	const aabb_soa boxes = make();
+	std::vector<aabb> aos(count);
+	for (size_t i = 0; i < count; i++) aos[i] = boxes.get(i);
+	state.items = count * (count - 1) / 2;
+	for (auto _ : state)
+	{
+		size_t hits = 0;
+		for (size_t i = 0; i < count; i++) for (size_t j = i + 1; j < count; j++) hits += fixp_overlaps(aos[i], aos[j]);
+		bench_keep(hits);
+	}
+}
+
+// all pairs, each box against all of them with the batched kernel
+BENCH(all_pairs_batched_1k)
+{
+	const aabb_soa boxes = make();
+	std::vector<uint64_t> mask(count / 64);
+	state.items = count * count;
+	for (auto _ : state)
+	{
+		size_t hits = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			fixp_overlaps_n(boxes.get(i), boxes, mask.data());
+			for (uint64_t m : mask) hits += __builtin_popcountll(m);
+		}
+		bench_keep(hits);
+	}
+}
+
+// sweep and prune from scratch each time
+BENCH(sweep_and_prune_cold_1k)
+{
+	const aabb_soa boxes = make();
+	state.items = count;
+	for (auto _ : state)
+	{
+		sweep_and_prune sap;
+		bench_keep(sap.update(boxes).size());
+	}
+}
+
+// sweep and prune with the boxes moving a little each frame
+BENCH(sweep_and_prune_coherent_1k)
+{
+	aabb_soa boxes = make();
+	sweep_and_prune sap;
+	sap.update(boxes);
+	uint64_t rng = 5;
+	state.items = count;
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const int64_t d = ((int64_t)(xorshift64(rng) % 3) - 1) << 20;
+			boxes.min_x[i] += d;
+			boxes.max_x[i] += d;
+		}
+		bench_keep(sap.update(boxes).size());
+	}
+}
+
+BENCH_MAIN()
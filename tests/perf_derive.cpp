@@ -1,16 +1,33 @@
 #include "dice.h"
-#include <assert.h>
-#include <stdio.h>
+#include "bench.h"
 
 // test performance of the derive() call
-int main(int argc, char **argv)
+BENCH(derive)
 {
-	seed s = seed_random();
+	seed s(1);
 	uint64_t sum = 0;
-	for (int i = 1; i < 50000; i++)
+	uint64_t i = 0;
+	for (auto _ : state)
 	{
 		const seed s2 = s.derive(i, i);
 		sum += s2.state;
+		i++;
 	}
-	return (int)sum * 0;
+	bench_keep(sum);
 }
+
+// the same, with the hashing done by the bulk kernel
+BENCH(splitmix64_n_1k)
+{
+	std::vector<uint64_t> in(1000);
+	std::vector<uint64_t> out(1000);
+	for (int i = 0; i < 1000; i++) in[i] = i;
+	state.items = 1000;
+	for (auto _ : state)
+	{
+		splitmix64_n(in.data(), out.data(), in.size());
+		bench_keep(out[0]);
+	}
+}
+
+BENCH_MAIN()
@@ -0,0 +1,90 @@
+#include "direction.h"
+#include "bench.h"
+
+#include <vector>
+
+static const size_t count = 4096;
+
+static std::vector<direction> make()
+{
+	std::vector<direction> v(count);
+	uint64_t state = 1;
+	for (size_t i = 0; i < count; i++) v[i] = xorshift64(state);
+	return v;
+}
+
+// rotating a fan of projectiles, one call at a time
+BENCH(isin_scalar_4k)
+{
+	const std::vector<direction> in = make();
+	std::vector<int32_t> out(count);
+	state.items = count;
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < count; i++) out[i] = isin(in[i]);
+		bench_keep(out[0]);
+	}
+}
+
+BENCH(isin_lerp_scalar_4k)
+{
+	const std::vector<direction> in = make();
+	std::vector<int32_t> out(count);
+	state.items = count;
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < count; i++) out[i] = isin_lerp(in[i]);
+		bench_keep(out[0]);
+	}
+}
+
+// the same with the array versions
+BENCH(isin_n_polynomial_4k)
+{
+	const std::vector<direction> in = make();
+	std::vector<int32_t> out(count);
+	state.items = count;
+	for (auto _ : state)
+	{
+		isin_n<isin_method::polynomial>(in.data(), out.data(), count);
+		bench_keep(out[0]);
+	}
+}
+
+BENCH(isin_n_table_4k)
+{
+	const std::vector<direction> in = make();
+	std::vector<int32_t> out(count);
+	state.items = count;
+	for (auto _ : state)
+	{
+		isin_n<isin_method::table>(in.data(), out.data(), count);
+		bench_keep(out[0]);
+	}
+}
+
+BENCH(sincos_n_polynomial_4k)
+{
+	const std::vector<direction> in = make();
+	std::vector<int32_t> s(count), c(count);
+	state.items = count;
+	for (auto _ : state)
+	{
+		sincos_n<isin_method::polynomial>(in.data(), s.data(), c.data(), count);
+		bench_keep(s[0]);
+	}
+}
+
+BENCH(sincos_n_table_4k)
+{
+	const std::vector<direction> in = make();
+	std::vector<int32_t> s(count), c(count);
+	state.items = count;
+	for (auto _ : state)
+	{
+		sincos_n<isin_method::table>(in.data(), s.data(), c.data(), count);
+		bench_keep(s[0]);
+	}
+}
+
+BENCH_MAIN()
@@ -0,0 +1,117 @@
+#include "fixp.h"
+#include "bench.h"
+
+#include <vector>
+
+static const size_t count = 4096;
+
+static std::vector<fixp> make()
+{
+	std::vector<fixp> v(count);
+	uint64_t state = 1;
+	for (size_t i = 0; i < count; i++) v[i].val = (int64_t)xorshift64(state) >> 24;
+	return v;
+}
+
+// dividing many values by one scale factor
+BENCH(divide_operator_4k)
+{
+	const std::vector<fixp> in = make();
+	std::vector<fixp> out(count);
+	fixp scale = fixp(7) / 3;
+	bench_keep(scale);
+	state.items = count;
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < count; i++) out[i] = in[i] / scale;
+		bench_keep(out[0]);
+	}
+}
+
+BENCH(divide_divider_4k)
+{
+	const std::vector<fixp> in = make();
+	std::vector<fixp> out(count);
+	fixp scale = fixp(7) / 3;
+	bench_keep(scale);
+	state.items = count;
+	for (auto _ : state)
+	{
+		const fixp_divider div(scale);
+		div.divide_n(in.data(), out.data(), count);
+		bench_keep(out[0]);
+	}
+}
+
+BENCH(divide_divider16_4k)
+{
+	std::vector<fixp16> in(count), out(count);
+	uint64_t rng = 1;
+	for (size_t i = 0; i < count; i++) in[i].val = (int32_t)(xorshift64(rng) >> 40);
+	fixp16 scale = fixp16(7) / 3;
+	bench_keep(scale);
+	state.items = count;
+	for (auto _ : state)
+	{
+		const fixp16_divider div(scale);
+		div.divide_n(in.data(), out.data(), count);
+		bench_keep(out[0]);
+	}
+}
+
+BENCH(divide_operator16_4k)
+{
+	std::vector<fixp16> in(count), out(count);
+	uint64_t rng = 1;
+	for (size_t i = 0; i < count; i++) in[i].val = (int32_t)(xorshift64(rng) >> 40);
+	fixp16 scale = fixp16(7) / 3;
+	bench_keep(scale);
+	state.items = count;
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < count; i++) out[i] = in[i] / scale;
+		bench_keep(out[0]);
+	}
+}
+
+// steering: turning velocities into headings and back
+BENCH(atan2_4k)
+{
+	const std::vector<fixp> x = make();
+	const std::vector<fixp> y = make();
+	std::vector<direction> out(count);
+	state.items = count;
+	for (auto _ : state)
+	{
+		fixp_atan2_n(y.data() + 1, x.data(), out.data(), count - 1);
+		bench_keep(out[0]);
+	}
+}
+
+BENCH(sincos_4k)
+{
+	std::vector<direction> in(count);
+	std::vector<fixp> s(count), c(count);
+	uint64_t rng = 1;
+	for (size_t i = 0; i < count; i++) in[i] = xorshift64(rng);
+	state.items = count;
+	for (auto _ : state)
+	{
+		fixp_sincos_n(in.data(), s.data(), c.data(), count);
+		bench_keep(s[0]);
+	}
+}
+
+BENCH(acos_4k)
+{
+	std::vector<fixp> in(count), out(count);
+	for (size_t i = 0; i < count; i++) in[i] = fixp((double)i / count * 2 - 1);
+	state.items = count;
+	for (auto _ : state)
+	{
+		fixp_acos_n(in.data(), out.data(), count);
+		bench_keep(out[0]);
+	}
+}
+
+BENCH_MAIN()
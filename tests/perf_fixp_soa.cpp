@@ -0,0 +1,69 @@
+#include "fixp_soa.h"
+#include "bench.h"
+
+static const size_t count = 200000;
+
+template<typename T> static fixed_vec2_soa<T> make(uint64_t seed)
+{
+	fixed_vec2_soa<T> v(count);
+	for (size_t i = 0; i < count; i++) { v.x[i] = xorshift64(seed) & 0xffffff; v.y[i] = xorshift64(seed) & 0xffffff; }
+	return v;
+}
+
+// the movement update pos += vel * dt with the scalar operators on an array of structs
+BENCH(axpy_aos_200k)
+{
+	const ivec2_soa p = make<fixp>(1), v = make<fixp>(2);
+	std::vector<ivec2> pos(count), vel(count);
+	for (size_t i = 0; i < count; i++) { pos[i] = p.get(i); vel[i] = v.get(i); }
+	const fixp dt = fixp(1) / 60;
+	state.items = count;
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < count; i++) { pos[i].x += vel[i].x * dt; pos[i].y += vel[i].y * dt; }
+		bench_keep(pos[0]);
+	}
+}
+
+// the same with the batched kernel on separate arrays
+BENCH(axpy_soa_200k)
+{
+	ivec2_soa pos = make<fixp>(1);
+	const ivec2_soa vel = make<fixp>(2);
+	const fixp dt = fixp(1) / 60;
+	state.items = count;
+	for (auto _ : state)
+	{
+		fixp_axpy_n(pos, vel, dt);
+		bench_keep(pos.x[0]);
+	}
+}
+
+// and with the compact 32 bit layout
+BENCH(axpy_soa16_200k)
+{
+	ivec2_16_soa pos = make<fixp16>(1);
+	const ivec2_16_soa vel = make<fixp16>(2);
+	const fixp16 dt = fixp16(1) / 60;
+	state.items = count;
+	for (auto _ : state)
+	{
+		fixp_axpy_n(pos, vel, dt);
+		bench_keep(pos.x[0]);
+	}
+}
+
+BENCH(distance_sq_soa_200k)
+{
+	const ivec2_soa a = make<fixp>(1);
+	std::vector<fixp> out(count);
+	const ivec2 p = a.get(0);
+	state.items = count;
+	for (auto _ : state)
+	{
+		fixp_distance_sq_n(a, p, out.data());
+		bench_keep(out[0]);
+	}
+}
+
+BENCH_MAIN()
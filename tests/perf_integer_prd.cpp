@@ -0,0 +1,46 @@
+#include "dice.h"
+#include "bench.h"
+
+// test performance of the integer_prd roll() call
+BENCH(linear_series_modulo)
+{
+	seed s(1);
+	volatile uint32_t range_in = 6;
+	const uint32_t range = range_in; // not known at compile time, as the old hardware division did
+	linear_series ls(s, 4095);
+	uint64_t sum = 0;
+	for (auto _ : state) sum += 1 + (ls.roll() % range);
+	bench_keep(sum);
+}
+
+BENCH(integer_prd)
+{
+	seed s(1);
+	integer_prd ip(s, 1, 6, 4095);
+	uint64_t sum = 0;
+	for (auto _ : state) sum += ip.roll();
+	bench_keep(sum);
+}
+
+BENCH(static_integer_prd)
+{
+	seed s(1);
+	static_integer_prd<1, 6> sip(s, 4095);
+	uint64_t sum = 0;
+	for (auto _ : state) sum += sip.roll();
+	bench_keep(sum);
+}
+
+BENCH(integer_prd_roll_n_400k)
+{
+	seed s(1);
+	integer_prd catchup(s, 1, 6, 4095);
+	state.items = 400000;
+	for (auto _ : state)
+	{
+		const std::vector<uint64_t> h = catchup.roll_n(400000);
+		bench_keep(h[0]);
+	}
+}
+
+BENCH_MAIN()
@@ -1,16 +1,9 @@
 #include "perten.h"
-#include <assert.h>
-#include <stdio.h>
-#include <stdint.h>
-#include <inttypes.h>
-#include <algorithm>
-#include <limits>
-#include <array>
+#include "bench.h"
 
-static perten a = perten_empty;
-
-int main(int argc, char **argv)
+BENCH(perten_apply_128x128)
 {
+	perten a = perten_empty;
 	lazy_conditional_matrix<128, 128> m;
 	for (int i = 0; i < 128; i++)
 	{
@@ -19,13 +12,13 @@ int main(int argc, char **argv)
 			m.modify(i, j, perten{140});
 		}
 	}
-	for (int i = 0; i < 128; i++)
+	state.items = 128;
+	for (auto _ : state)
 	{
 		perten p = perten_empty;
 		for (int j = 0; j < 128; j++) p += perten_apply(a, m.row(j));
-		for (int j = 0; j < 128; j++) p += perten_apply(a, m.row(j));
-		for (int j = 0; j < 128; j++) p += perten_apply(a, m.row(j));
+		bench_keep(p);
 	}
-
-	return perten_to_int(a);
 }
+
+BENCH_MAIN()
@@ -1,12 +1,12 @@
 #include "dice.h"
+#include "bench.h"
 
-int main(int argc, char **argv)
+BENCH(pow2_weighted_roll)
 {
-	seed s = seed_random();
+	seed s(1);
 	uint64_t sum = 0;
-	for (int i = 1; i < 50000; i++)
-	{
-		sum += s.pow2_weighted_roll(21);
-	}
-	return (int)sum * 0;
+	for (auto _ : state) sum += s.pow2_weighted_roll(21);
+	bench_keep(sum);
 }
+
+BENCH_MAIN()
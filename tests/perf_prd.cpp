@@ -1,16 +1,41 @@
 #include "dice.h"
-#include <assert.h>
-#include <stdio.h>
+#include "bench.h"
 
 // test performance of the prd class
-int main(int argc, char **argv)
+BENCH(prd)
 {
-	seed s = seed_random();
+	seed s(1);
 	prd p(s, 15); // 1.5% chance
 	uint64_t sum = 0;
-	for (int i = 1; i < 50000; i++)
+	for (auto _ : state) sum += p.roll();
+	bench_keep(sum);
+}
+
+// the same for a pool of them, rolling every other entry each tick
+BENCH(prd_pool_4k_masked)
+{
+	seed s(1);
+	prd_pool pool;
+	for (int i = 0; i < 4096; i++) pool.add(s.derive(i), 15);
+	std::vector<uint64_t> mask(pool.words(), 0x5555555555555555ull);
+	std::vector<uint64_t> result(pool.words());
+	uint64_t sum = 0;
+	state.items = 2048;
+	for (auto _ : state)
 	{
-		if (p.roll()) sum++;
+		pool.roll_masked(mask.data(), result.data());
+		sum += result[0] & 1;
 	}
-	return (int)sum * 0;
+	bench_keep(sum);
 }
+
+BENCH(compact_prd)
+{
+	seed s(1);
+	compact_prd p(s, 0, 15);
+	uint64_t sum = 0;
+	for (auto _ : state) sum += p.roll(s, 0);
+	bench_keep(sum);
+}
+
+BENCH_MAIN()
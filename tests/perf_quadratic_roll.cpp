@@ -1,12 +1,34 @@
 #include "dice.h"
+#include "bench.h"
 
-int main(int argc, char **argv)
+BENCH(quadratic_weighted_roll)
 {
-	seed s = seed_random();
+	seed s(1);
 	uint64_t sum = 0;
-	for (int i = 1; i < 50000; i++)
+	for (auto _ : state) sum += s.quadratic_weighted_roll(21);
+	bench_keep(sum);
+}
+
+BENCH(isqrt)
+{
+	uint64_t x = 1;
+	uint64_t sum = 0;
+	for (auto _ : state) sum += isqrt(xorshift64(x));
+	bench_keep(sum);
+}
+
+BENCH(isqrt_n_1k)
+{
+	uint64_t x = 1;
+	std::vector<uint64_t> in(1000);
+	std::vector<uint64_t> out(1000);
+	for (uint64_t& v : in) v = xorshift64(x);
+	state.items = 1000;
+	for (auto _ : state)
 	{
-		sum += s.quadratic_weighted_roll(21);
+		isqrt_n(in.data(), out.data(), in.size());
+		bench_keep(out[0]);
 	}
-	return (int)sum * 0;
 }
+
+BENCH_MAIN()
@@ -1,15 +1,34 @@
 #include "dice.h"
-#include <assert.h>
-#include <stdio.h>
+#include "bench.h"
 
 // test performance of the roll() call
-int main(int argc, char **argv)
+BENCH(roll)
 {
-	seed s = seed_random();
+	seed s(1);
 	uint64_t sum = 0;
-	for (int i = 1; i < 500000; i++)
+	int i = 1;
+	for (auto _ : state)
 	{
 		sum += s.roll(i >> 2, i);
+		i = (i & 0xfffff) + 1;
 	}
-	return (int)sum * 0;
+	bench_keep(sum);
 }
+
+// the same, with the bulk kernels
+BENCH(fastrange_n_1k)
+{
+	seed s(1);
+	std::vector<uint64_t> states(1000);
+	std::vector<uint64_t> out(1000);
+	for (uint64_t& v : states) v = splitmix64(s.state++);
+	state.items = 1000;
+	for (auto _ : state)
+	{
+		xorshift64_n(states.data(), states.size());
+		fastrange_n(states.data(), 0, 99, out.data(), out.size());
+		bench_keep(out[0]);
+	}
+}
+
+BENCH_MAIN()
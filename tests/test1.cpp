@@ -189,6 +189,259 @@ static void test_linear_series_3()
 	}
 }
 
+static void test_linear_series_bulk()
+{
+	const unsigned sizes[] = { 1, 2, 3, 4, 5, 100, 4095, 5000 };
+	const int chunks[] = { 1, 63, 64, 1000, 7, 8936, 200 };
+	for (unsigned size : sizes)
+	{
+		seed s(size);
+		linear_series a(s, size);
+		linear_series b(s, size);
+		std::vector<uint32_t> out(10000);
+		for (int n : chunks)
+		{
+			a.roll_n(n, out.data());
+			for (int i = 0; i < n; i++) { const auto r = b.roll(); assert(out[i] == r); }
+			assert(a.remaining() == b.remaining());
+		}
+		const uint64_t skips[] = { 0, 1, size - 1, size, size + 3, 100000 };
+		for (uint64_t n : skips)
+		{
+			a.skip(n);
+			for (uint64_t i = 0; i < n; i++) b.roll();
+			assert(a.remaining() == b.remaining());
+			for (int i = 0; i < 10; i++) { const auto ra = a.roll(); const auto rb = b.roll(); assert(ra == rb); }
+		}
+	}
+}
+
+static void test_linear_series_wide()
+{
+	// walk a 48 bit id space without storing it
+	seed s(48);
+	const uint64_t size = (1ull << 48) - 1;
+	linear_series a(s, size);
+	linear_series b(s, size);
+	assert(a.size() == size && a.reserved() == 1ull << 48);
+	std::vector<uint64_t> out(1000);
+	a.roll_n(1000, out.data());
+	for (uint64_t v : out) { const uint64_t r = b.roll(); assert(v < size && v == r); }
+	std::sort(out.begin(), out.end());
+	assert(std::adjacent_find(out.begin(), out.end()) == out.end());
+	a.skip(size - 2000); // jumps, since the size is one less than a power of two
+	for (int i = 0; i < 1000; i++) { const uint64_t r = a.roll(); assert(r < size); }
+	assert(a.remaining() == size); // just reset
+
+	// full 64 bit LFSR
+	uint64_t x = lfsr_init(1, 64);
+	const uint64_t start = x;
+	lfsr_next(x, lfsr_tap(64));
+	assert(x != start && x != 0);
+}
+
+static void test_prd_pool()
+{
+	const prd_function funcs[] = { prd_function::relaxed, prd_function::fair, prd_function::predictable };
+	for (prd_function f : funcs)
+	{
+		seed s(77);
+		prd_pool pool(f);
+		std::vector<prd> single;
+		for (int i = 0; i < 150; i++)
+		{
+			const seed d = s.derive(i);
+			const uint16_t chance = (i * 37) % 1001;
+			const uint32_t idx = pool.add(d, chance);
+			assert(idx == (uint32_t)i);
+			single.push_back(prd(d, chance, f));
+		}
+		std::vector<uint64_t> mask(pool.words());
+		std::vector<uint64_t> result(pool.words());
+		for (int round = 0; round < 500; round++)
+		{
+			for (uint64_t& m : mask) m = xorshift64(s.state);
+			if (round % 7 == 0) mask[1] = 0;
+			if (round % 5 == 0) mask[0] = ~0ull;
+			pool.roll_masked(mask.data(), result.data());
+			for (uint32_t i = 0; i < pool.size(); i++)
+			{
+				const bool selected = (mask[i / 64] >> (i % 64)) & 1;
+				const bool r = (result[i / 64] >> (i % 64)) & 1;
+				const bool expected = selected && single[i].roll();
+				assert(r == expected);
+			}
+		}
+		const uint32_t ids[] = { 3, 140, 3, 64, 0 };
+		for (int round = 0; round < 100; round++)
+		{
+			pool.roll_ids(ids, 5, result.data());
+			bool expected[150];
+			for (uint32_t id : ids) expected[id] = single[id].roll(); // duplicates keep the last result
+			for (uint32_t id : ids) assert(((result[id / 64] >> (id % 64)) & 1) == expected[id]);
+		}
+		for (uint32_t i = 0; i < pool.size(); i++) assert(pool.accum[i] == single[i].accum && pool.remainder[i] == single[i].remainder && pool.state[i] == single[i].state);
+	}
+
+	// A size that is not a multiple of 64, rolled with every mask bit set, gives no results past the last entry
+	for (uint32_t size : { 3u, 70u })
+	{
+		seed s(5);
+		prd_pool pool(prd_function::fair);
+		for (uint32_t i = 0; i < size; i++) pool.add(s.derive(i), 1000);
+		std::vector<uint64_t> mask(pool.words(), ~0ull);
+		std::vector<uint64_t> result(pool.words());
+		pool.roll_masked(mask.data(), result.data());
+		for (uint32_t w = 0; w < pool.words(); w++)
+		{
+			const uint32_t valid = std::min<uint32_t>(64, size - w * 64);
+			assert(result[w] == (valid == 64 ? ~0ull : (1ull << valid) - 1)); // all entries always succeed
+		}
+	}
+}
+
+static void test_compact_prd()
+{
+	const seed parent(99);
+	// same fairness guarantee as prd
+	for (uint64_t id = 0; id < 100; id++)
+	{
+		compact_prd p(parent, id, 100, prd_function::fair); // 10% chance
+		int j = 0;
+		for (; j < 5; j++) { const bool r = p.roll(parent, id); assert(!r); }
+		while (!p.roll(parent, id)) j++;
+		for (; j < 5; j++) { const bool r = p.roll(parent, id); assert(!r); }
+	}
+	// deterministic from parent, id and reset count alone
+	compact_prd a(parent, 7, 30, prd_function::relaxed);
+	compact_prd b(parent, 7, 30, prd_function::relaxed);
+	compact_prd c(parent, 8, 30, prd_function::relaxed);
+	int hits = 0;
+	bool differ = false;
+	for (int i = 0; i < 100000; i++)
+	{
+		const bool r = a.roll(parent, 7);
+		const bool rb = b.roll(parent, 7);
+		assert(r == rb);
+		if (r != c.roll(parent, 8)) differ = true;
+		hits += r;
+	}
+	assert(differ);
+	assert(hits > 2700 && hits < 3300);
+	assert(a.resets == b.resets && a.resets > 0);
+	// extremes and inverted chances
+	compact_prd never(parent, 1, 0, prd_function::predictable);
+	compact_prd always(parent, 2, 1000, prd_function::predictable);
+	for (int i = 0; i < 10; i++)
+	{
+		const bool rn = never.roll(parent, 1);
+		const bool ra = always.roll(parent, 2);
+		assert(!rn && ra);
+	}
+}
+
+static void test_catch_up()
+{
+	const prd_function funcs[] = { prd_function::relaxed, prd_function::fair, prd_function::predictable };
+	const uint16_t chances[] = { 0, 1, 15, 333, 500, 501, 900, 1000 };
+	const uint64_t counts[] = { 0, 1, 2, 7, 1000, 123457 };
+	for (prd_function f : funcs) for (uint16_t c : chances)
+	{
+		seed s(c + 1);
+		prd a(s, c, f);
+		prd b(s, c, f);
+		for (uint64_t n : counts)
+		{
+			uint64_t hits = 0;
+			for (uint64_t i = 0; i < n; i++) hits += b.roll();
+			const uint64_t got = a.roll_n(n);
+			assert(got == hits);
+			assert(a.accum == b.accum && a.remainder == b.remainder && a.state == b.state);
+		}
+	}
+
+	const uint64_t ncounts[] = { 0, 1, 99, 100, 101, 1000, 54321 };
+	for (int window : { 1, 2, 3, 64, 100, 127 })
+	{
+		seed s(window);
+		integer_prd a(s, 5, 14, window);
+		integer_prd b(s, 5, 14, window);
+		for (uint64_t n : ncounts)
+		{
+			std::vector<uint64_t> expected(10, 0);
+			for (uint64_t i = 0; i < n; i++) expected[b.roll() - 5]++;
+			const std::vector<uint64_t> got = a.roll_n(n);
+			assert(got == expected);
+			assert(a.remaining() == b.remaining());
+			for (int i = 0; i < 5; i++) { const int ra = a.roll(); const int rb = b.roll(); assert(ra == rb); }
+		}
+	}
+}
+
+static void test_integer_prd_fastmod()
+{
+	seed s(5);
+	const uint32_t divisors[] = { 1, 2, 3, 6, 7, 10, 100, 1000, 65535, 65536, 1000003, INT32_MAX, UINT32_MAX };
+	for (uint32_t d : divisors)
+	{
+		const uint64_t magic = fastmod32_magic(d);
+		for (int i = 0; i < 10000; i++)
+		{
+			const uint32_t a = (i < 100) ? i : (i < 200) ? UINT32_MAX - i : (uint32_t)xorshift64(s.state);
+			assert(fastmod32(a, magic, d) == a % d);
+		}
+	}
+
+	linear_series ls(s, 100);
+	integer_prd ip(s, 3, 9, 100);
+	static_integer_prd<3, 9> sip(s, 100);
+	for (int i = 0; i < 1000; i++)
+	{
+		const int expected = 3 + ls.roll() % 7;
+		const int r1 = ip.roll();
+		const int r2 = sip.roll();
+		assert(r1 == expected && r2 == expected);
+	}
+}
+
+static void test_weighted_bag()
+{
+	const std::vector<int> weights { 1, 10, 0, 89 };
+	seed s(11);
+	weighted_bag bag(s, weights);
+	assert(bag.size() == 100);
+	assert(bag.weight(3) == 89 && bag.weight(2) == 0);
+	for (int window = 0; window < 20; window++)
+	{
+		int counts[4] = { 0, 0, 0, 0 };
+		for (int i = 0; i < 100; i++) counts[bag.roll()]++;
+		for (int i = 0; i < 4; i++) assert(counts[i] == weights[i]);
+		assert(bag.remaining() == 100);
+	}
+
+	// luck keeps the totals, but moves the rare entry earlier, or holds it back
+	for (luck_type luck : { luck_type::lucky, luck_type::unlucky })
+	{
+		weighted_bag lb(s, weights);
+		int counts[4] = { 0, 0, 0, 0 };
+		long first_pos = 0;
+		const int windows = 200;
+		for (int window = 0; window < windows; window++)
+		{
+			bool found = false;
+			for (int i = 0; i < 100; i++)
+			{
+				const int r = lb.roll(luck);
+				counts[r]++;
+				if (r == 0 && !found) { first_pos += i; found = true; }
+			}
+			if (window == 0 && luck == luck_type::unlucky) assert(!found); // always the rarer, so held back until the next window
+		}
+		for (int i = 0; i < 4; i++) assert(counts[i] >= weights[i] * windows - 1 && counts[i] <= weights[i] * windows + 1);
+		if (luck == luck_type::lucky) assert(first_pos / windows < 45);
+	}
+}
+
 static void test_const_roll_table_1()
 {
 	std::vector<int> w{ 50, 50, 100, 100 };
@@ -399,6 +652,13 @@ int main(int argc, char **argv)
 	test_linear_series_1();
 	test_linear_series_2();
 	test_linear_series_3();
+	test_linear_series_bulk();
+	test_linear_series_wide();
+	test_prd_pool();
+	test_compact_prd();
+	test_catch_up();
+	test_integer_prd_fastmod();
+	test_weighted_bag();
 	linear_roll_table_test();
 	edge_cases();
 	test_pow2_weighted_roll_distribution();
@@ -0,0 +1,159 @@
+#include "aabb_tree.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+
+static aabb random_box(uint64_t& state)
+{
+	aabb b;
+	b.min.x = fixp((int)(xorshift64(state) % 1000)) / 4;
+	b.min.y = fixp((int)(xorshift64(state) % 1000)) / 4;
+	b.max.x = b.min.x + fixp((int)(xorshift64(state) % 40)) / 8;
+	b.max.y = b.min.y + fixp((int)(xorshift64(state) % 40)) / 8;
+	return b;
+}
+
+static ivec2 random_point(uint64_t& state)
+{
+	return ivec2{ fixp((int)(xorshift64(state) % 1100) - 50) / 4, fixp((int)(xorshift64(state) % 1100) - 50) / 4 };
+}
+
+// Every query must find exactly what testing all entries finds
+static void check_queries(const aabb_tree& tree, const std::map<int32_t, aabb>& live, uint64_t& state)
+{
+	for (int q = 0; q < 10; q++)
+	{
+		const aabb region = random_box(state);
+		std::vector<int32_t> found, expected;
+		tree.query(region, found);
+		for (const auto& [id, b] : live) if (fixp_overlaps(b, region)) expected.push_back(id);
+		std::sort(found.begin(), found.end());
+		assert(found == expected);
+
+		const ivec2 c = random_point(state);
+		const fixp r = fixp((int)(xorshift64(state) % 100)) / 8;
+		found.clear(); expected.clear();
+		tree.query_radius(c, r, found);
+		for (const auto& [id, b] : live)
+		{
+			const ivec2 nearest = { std::clamp(c.x, b.min.x, b.max.x), std::clamp(c.y, b.min.y, b.max.y) };
+			const fixp dx = c.x - nearest.x, dy = c.y - nearest.y;
+			if (dx * dx + dy * dy <= r * r) expected.push_back(id);
+		}
+		std::sort(found.begin(), found.end());
+		assert(found == expected);
+
+		const ivec2 from = random_point(state), to = random_point(state);
+		found.clear(); expected.clear();
+		int32_t first = aabb_tree::null_node;
+		fixp first_t = 2, t;
+		tree.query_ray(from, to, [&](int32_t id, fixp t) { found.push_back(id); assert(t >= 0 && t <= 1); return true; });
+		for (const auto& [id, b] : live)
+		{
+			if (!aabb_tree::segment_enters(b, from, to, t)) continue;
+			expected.push_back(id);
+			if (t < first_t) { first = id; first_t = t; }
+		}
+		std::sort(found.begin(), found.end());
+		assert(found == expected);
+		assert(tree.raycast(from, to, t) == first);
+		if (first != aabb_tree::null_node) assert(t == first_t);
+	}
+}
+
+static void test_random()
+{
+	uint64_t state = 1234;
+	aabb_tree tree(fixp(1) / 2);
+	std::map<int32_t, aabb> live;
+	for (int step = 0; step < 3000; step++)
+	{
+		const int op = xorshift64(state) % 10;
+		if (op < 4 || live.empty())
+		{
+			const aabb b = random_box(state);
+			const int32_t id = tree.insert(b, step);
+			assert(!live.count(id));
+			live[id] = b;
+			assert(tree.user(id) == (uint32_t)step);
+		}
+		else if (op < 6)
+		{
+			auto it = live.begin();
+			std::advance(it, xorshift64(state) % live.size());
+			tree.remove(it->first);
+			live.erase(it);
+		}
+		else
+		{
+			auto it = live.begin();
+			std::advance(it, xorshift64(state) % live.size());
+			aabb b = it->second;
+			const fixp dx = fixp((int)(xorshift64(state) % 9) - 4) / 8, dy = fixp((int)(xorshift64(state) % 9) - 4) / 8;
+			b.min.x += dx; b.max.x += dx; b.min.y += dy; b.max.y += dy;
+			tree.move(it->first, b);
+			it->second = b;
+			assert(tree.box(it->first).min.x == b.min.x);
+		}
+		assert(tree.size() == (int32_t)live.size());
+		if (step % 100 == 0) { assert(tree.validate()); check_queries(tree, live, state); }
+	}
+	assert(tree.validate());
+	// balanced, so the height stays logarithmic
+	assert(tree.height() <= 2 * 32 - __builtin_clz(tree.size()));
+}
+
+// The same calls give the same tree, so queries give the same order
+static void test_determinism()
+{
+	std::vector<int32_t> orders[2];
+	for (int run = 0; run < 2; run++)
+	{
+		uint64_t state = 77;
+		aabb_tree tree(fixp(1) / 4);
+		std::vector<int32_t> ids;
+		for (int i = 0; i < 500; i++) ids.push_back(tree.insert(random_box(state), i));
+		for (int i = 0; i < 500; i += 3) { aabb b = tree.box(ids[i]); b.min.x += 10; b.max.x += 10; tree.move(ids[i], b); }
+		tree.query(aabb{ { 0, 0 }, { 250, 250 } }, orders[run]);
+	}
+	assert(orders[0].size() > 400);
+	assert(orders[0] == orders[1]);
+}
+
+static void test_edges()
+{
+	aabb_tree tree;
+	fixp t;
+	assert(tree.raycast(ivec2{ 0, 0 }, ivec2{ 1, 1 }, t) == aabb_tree::null_node);
+	assert(tree.height() == 0 && tree.validate());
+	const int32_t a = tree.insert(aabb{ { 2, -1 }, { 3, 1 } }, 0);
+	const int32_t b = tree.insert(aabb{ { 2, 1 }, { 3, 2 } }, 1); // shares an edge with a
+	const int32_t c = tree.insert(aabb{ { 6, -1 }, { 7, 1 } }, 2);
+	assert(tree.raycast(ivec2{ 0, 0 }, ivec2{ 10, 0 }, t) == a && t == fixp(0.2));
+	assert(tree.raycast(ivec2{ 10, 0 }, ivec2{ 0, 0 }, t) == c && t == fixp(0.3));
+	assert(tree.raycast(ivec2{ 0, 1 }, ivec2{ 10, 1 }, t) == std::min(a, b)); // hits both at once
+	assert(tree.raycast(ivec2{ 0, 0 }, ivec2{ 1.5, 0 }, t) == aabb_tree::null_node); // stops short
+	assert(tree.raycast(ivec2{ 2.5, 0 }, ivec2{ 2.5, 0 }, t) == a && t == 0); // starts inside
+	std::vector<int32_t> found;
+	tree.query_radius(ivec2{ 4, 0 }, fixp(1), found);
+	assert(found.size() == 1 && found[0] == a);
+	found.clear();
+	ivec2 far = { 0, 0 }; far.x.val = 1ll << 60;
+	fixp r; r.val = (1ll << 60) - (1ll << 26); // between the distances to c and a, far beyond what fixp can square
+	tree.query_radius(far, r, found);
+	assert(found.size() == 1 && found[0] == c);
+	tree.remove(b);
+	tree.remove(a);
+	tree.remove(c);
+	assert(tree.size() == 0 && tree.validate());
+}
+
+int main(int argc, char **argv)
+{
+	test_edges();
+	test_random();
+	test_determinism();
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include "broadphase.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+// Boxes of up to 'size' across, placed in a square 'world' across, in whole units
+template<typename T> static fixed_aabb<T> random_box(uint64_t& state, int world, int size)
+{
+	fixed_aabb<T> b;
+	b.min.x = T((int)(xorshift64(state) % world));
+	b.min.y = T((int)(xorshift64(state) % world));
+	b.max.x = b.min.x + T((int)(xorshift64(state) % size));
+	b.max.y = b.min.y + T((int)(xorshift64(state) % size));
+	return b;
+}
+
+template<typename T> static std::vector<box_pair> brute_force(const fixed_aabb_soa<T>& boxes)
+{
+	std::vector<box_pair> r;
+	for (uint32_t i = 0; i < boxes.size(); i++) for (uint32_t j = i + 1; j < boxes.size(); j++) if (fixp_overlaps(boxes.get(i), boxes.get(j))) r.push_back({ i, j });
+	return r;
+}
+
+template<typename T> static void test_mask()
+{
+	uint64_t state = 7;
+	for (size_t n : { 0, 1, 5, 63, 64, 65, 200, 1000 })
+	{
+		fixed_aabb_soa<T> boxes;
+		for (size_t i = 0; i < n; i++) boxes.push_back(random_box<T>(state, 100, 20));
+		for (int q = 0; q < 20; q++)
+		{
+			const fixed_aabb<T> box = random_box<T>(state, 100, 30);
+			std::vector<uint64_t> mask((n + 63) / 64, ~0ull);
+			fixp_overlaps_n(box, boxes, mask.data());
+			for (size_t i = 0; i < mask.size() * 64; i++)
+			{
+				const bool bit = (mask[i / 64] >> (i % 64)) & 1;
+				assert(bit == (i < n && fixp_overlaps(box, boxes.get(i))));
+			}
+		}
+	}
+}
+
+template<typename T> static void test_sweep_and_prune()
+{
+	uint64_t state = 99;
+	fixed_aabb_soa<T> boxes;
+	for (int i = 0; i < 500; i++) boxes.push_back(random_box<T>(state, 200, 12));
+	fixed_sweep_and_prune<T> sap;
+	for (int frame = 0; frame < 30; frame++)
+	{
+		const std::vector<box_pair>& pairs = sap.update(boxes);
+		assert(pairs == brute_force(boxes));
+		assert(std::is_sorted(pairs.begin(), pairs.end()));
+		// the same boxes from scratch give the same list
+		fixed_sweep_and_prune<T> fresh;
+		assert(fresh.update(boxes) == pairs);
+		if (frame > 0 && frame < 10) assert(sap.sort_moves() < boxes.size()); // coherent frames need little sorting
+
+		// move every box a little, and sometimes add or remove some
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			fixed_aabb<T> b = boxes.get(i);
+			const T dx = T((int)(xorshift64(state) % 3) - 1) / 4;
+			const T dy = T((int)(xorshift64(state) % 3) - 1) / 4;
+			b.min.x += dx; b.max.x += dx; b.min.y += dy; b.max.y += dy;
+			boxes.set(i, b);
+		}
+		if (frame == 12) for (int i = 0; i < 50; i++) boxes.push_back(random_box<T>(state, 200, 12));
+		if (frame == 20) boxes.resize(300);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const cpu_level best = cpu_level_detect();
+	for (int level = 0; level <= (int)best; level++)
+	{
+		cpu_level_set((cpu_level)level);
+		test_mask<fixp>();
+		test_mask<fixp16>();
+	}
+	cpu_level_set(best);
+	test_mask<fixed<20, int64_t>>(); // not dispatched, uses the template
+
+	test_sweep_and_prune<fixp>();
+	test_sweep_and_prune<fixp16>();
+
+	// touching boxes overlap, just like fixp_overlaps
+	aabb_soa boxes;
+	boxes.push_back(aabb{ { 0, 0 }, { 1, 1 } });
+	boxes.push_back(aabb{ { 1, 1 }, { 2, 2 } });
+	boxes.push_back(aabb{ { 2.5, 0 }, { 3, 1 } });
+	sweep_and_prune sap;
+	assert(sap.update(boxes).size() == 1 && sap.pairs()[0] == (box_pair{ 0, 1 }));
+	uint64_t mask;
+	fixp_overlaps_n(aabb{ { 1, 1 }, { 2.5, 1 } }, boxes, &mask);
+	assert(mask == 7);
+	return 0;
+}
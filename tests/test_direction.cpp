@@ -1,9 +1,11 @@
 #include "direction.h"
+#include "dmath.h"
 
 #include <assert.h>
 #include <stdio.h>
 #include <cstdint>
 #include <cmath>
+#include <vector>
 
 int main()
 {
@@ -74,5 +76,41 @@ int main()
 	}
 	printf("snap tests passed\n");
 
+	// The table version is within one of the exact values, and within two of the polynomial
+	int lerp_err = 0, lerp_diff = 0;
+	for (int i = 0; i <= UINT16_MAX; i++)
+	{
+		const int s = isin_lerp(i);
+		const int c = icos_lerp(i);
+		lerp_err = std::max(lerp_err, std::abs(s - (int)lround(4096 * sin(2 * M_PI * i / 65536.0))));
+		lerp_err = std::max(lerp_err, std::abs(c - (int)lround(4096 * cos(2 * M_PI * i / 65536.0))));
+		lerp_diff = std::max(lerp_diff, std::max(std::abs(s - isin(i)), std::abs(c - icos(i))));
+	}
+	printf("isin_lerp max error: %d, max difference from isin: %d\n", lerp_err, lerp_diff);
+	assert(lerp_err <= 1 && lerp_diff <= 2);
+	assert(isin_lerp(0) == 0 && isin_lerp(16384) == 4096 && isin_lerp(32768) == 0 && isin_lerp(49152) == -4096);
+	assert(icos_lerp(0) == 4096 && icos_lerp(32768) == -4096);
+
+	// The array versions give the same results as the scalar ones at every instruction set level
+	const size_t n = 1000;
+	std::vector<direction> dirs(n);
+	for (size_t i = 0; i < n; i++) dirs[i] = i * 65537u / 7;
+	std::vector<int32_t> s1(n), c1(n), s2(n), c2(n);
+	const cpu_level best = cpu_level_detect();
+	for (int level = 0; level <= (int)best; level++)
+	{
+		cpu_level_set((cpu_level)level);
+		isin_n(dirs.data(), s1.data(), n);
+		icos_n(dirs.data(), c1.data(), n);
+		sincos_n<isin_method::table>(dirs.data(), s2.data(), c2.data(), n);
+		for (size_t i = 0; i < n; i++) assert(s1[i] == isin(dirs[i]) && c1[i] == icos(dirs[i]) && s2[i] == isin_lerp(dirs[i]) && c2[i] == icos_lerp(dirs[i]));
+		isin_n<isin_method::table>(dirs.data(), s1.data(), n);
+		icos_n<isin_method::table>(dirs.data(), c1.data(), n);
+		sincos_n(dirs.data(), s2.data(), c2.data(), n);
+		for (size_t i = 0; i < n; i++) assert(s1[i] == isin_lerp(dirs[i]) && c1[i] == icos_lerp(dirs[i]) && s2[i] == isin(dirs[i]) && c2[i] == icos(dirs[i]));
+	}
+	cpu_level_set(best);
+	printf("array tests passed\n");
+
 	return 0;
 }
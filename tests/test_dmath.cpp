@@ -2,6 +2,8 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 int main()
 {
@@ -31,12 +33,97 @@ int main()
 	assert(circular_distance(0, (uint32_t)INT32_MIN) == INT32_MIN);
 
 	// lfsr_tap edge cases and coverage
-	assert(lfsr_tap(2) == 0x3);
-	assert(lfsr_tap(32) == 0x80000057);
-	for (uint32_t size = 2; size <= 32; ++size)
+	static_assert(lfsr_tap(2) == 0x3);
+	static_assert(lfsr_tap(32) == 0x80000057);
+	static_assert(lfsr_tap(64) == 0x800000000000000Dull);
+	for (uint32_t size = 1; size <= 64; ++size)
 	{
-		assert(lfsr_tap(size) != 0);
+		const uint64_t tap = lfsr_tap(size);
+		assert(highestbitset(tap) == (int)size - 1);
+		// going around the whole period in two halves brings us back where we started
+		const uint64_t period = (size < 64) ? (1ull << size) - 1 : UINT64_MAX;
+		const uint64_t x = lfsr_init(size, size);
+		uint64_t y = x;
+		lfsr_next(y, tap);
+		assert(lfsr_skip(lfsr_skip(y, tap, size, period / 2), tap, size, period - period / 2) == y);
+		assert(size == 1 || lfsr_skip(y, tap, size, period / 2) != y);
 	}
+	for (uint32_t size = 1; size <= 16; ++size) // check the small ones the slow way
+	{
+		const uint64_t tap = lfsr_tap(size);
+		uint64_t x = 1;
+		uint64_t period = 0;
+		do { lfsr_next(x, tap); period++; } while (x != 1);
+		assert(period == (1ull << size) - 1);
+	}
+
+	// isqrt is exact and usable at compile time
+	static_assert(isqrt(0) == 0 && isqrt(1) == 1 && isqrt(15) == 3 && isqrt(16) == 4);
+	static_assert(isqrt32(UINT32_MAX) == 65535);
+	assert(isqrt(UINT64_MAX) == 4294967295ull);
+	for (uint64_t x = 0; x < (1u << 22); x++)
+	{
+		const uint64_t r = isqrt32(x);
+		assert(r * r <= x && (r + 1) * (r + 1) > x);
+	}
+	for (uint64_t r = 1; r < (1ull << 32); r += 1 + (r >> 3))
+	{
+		assert(isqrt(r * r) == r && isqrt(r * r - 1) == r - 1);
+		assert(r > UINT16_MAX || (isqrt32(r * r) == r && isqrt32(r * r - 1) == r - 1));
+	}
+	uint64_t v = 0x9E3779B97F4A7C15ull;
+	for (int i = 0; i < 100000; i++)
+	{
+		v ^= v << 13; v ^= v >> 7; v ^= v << 17;
+		for (uint64_t x : { v, v >> (i % 64) })
+		{
+			const unsigned __int128 r = isqrt(x);
+			assert(r * r <= x && (r + 1) * (r + 1) > x);
+		}
+	}
+
+	// batched versions agree with the scalar ones, on every instruction set level this CPU has
+	const char* env = getenv("DICEY_CPU_LEVEL");
+	if (env && strcmp(env, "scalar") == 0) assert(cpu_level_active() == cpu_level::scalar);
+	uint64_t in64[259];
+	uint64_t out64[259];
+	uint32_t in32[259];
+	uint32_t out32[259];
+	uint64_t states[259];
+	for (int i = 0; i < 259; i++)
+	{
+		v ^= v << 13; v ^= v >> 7; v ^= v << 17;
+		in64[i] = (i < 64) ? UINT64_MAX - i : v >> (i % 64);
+		in32[i] = (i < 64) ? i * i - 1 : (uint32_t)v;
+	}
+	for (int level = 0; level <= (int)cpu_level_detect(); level++)
+	{
+		assert(cpu_level_set((cpu_level)level) == (cpu_level)level);
+		assert(cpu_level_active() == (cpu_level)level);
+		for (size_t n : { 0, 1, 7, 64, 259 })
+		{
+			isqrt_n(in64, out64, n);
+			isqrt32_n(in32, out32, n);
+			std::copy_n(in64, n, states);
+			xorshift64_n(states, n);
+			for (size_t i = 0; i < n; i++)
+			{
+				assert(out64[i] == isqrt(in64[i]));
+				assert(out32[i] == isqrt32(in32[i]));
+				uint64_t x = in64[i];
+				assert(states[i] == xorshift64(x));
+			}
+			splitmix64_n(in64, states, n);
+			for (size_t i = 0; i < n; i++) assert(states[i] == splitmix64(in64[i]));
+			const uint64_t ranges[][2] = { { 0, 0 }, { 0, 5 }, { 7, 1000 }, { 0, UINT32_MAX }, { 1, 1ull << 40 }, { 3, UINT64_MAX - 1 }, { UINT64_MAX - 1, UINT64_MAX - 1 } };
+			for (const auto& r : ranges)
+			{
+				fastrange_n(states, r[0], r[1], out64, n);
+				for (size_t i = 0; i < n; i++) assert(out64[i] == fastrange(states[i], r[0], r[1]));
+			}
+		}
+	}
+	assert(cpu_level_set(cpu_level::avx512) == cpu_level_detect());
 
 	return 0;
 }
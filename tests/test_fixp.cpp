@@ -5,11 +5,96 @@
 #include <cstdint>
 #include <cmath>
 #include <limits.h>
+#include <type_traits>
+#include <limits>
+#include <vector>
 
 static inline double dotf(ivec2 a, ivec2 b) { return a.x.todouble() * b.x.todouble() + a.y.todouble() * b.y.todouble(); }
 
+static void test_layouts()
+{
+	static_assert(sizeof(fixp16) == 4 && sizeof(ivec2_16) == 8 && sizeof(aabb16) == 16);
+	static_assert(!std::is_convertible_v<fixp, fixp16> && !std::is_convertible_v<fixp16, fixp>);
+	static_assert(std::is_constructible_v<fixp16, fixp>);
+
+	fixp16 a = 100;
+	fixp16 b = 1.5;
+	assert(a * a == 10000); // would overflow 32 bits without widening
+	assert(a * b == 150);
+	assert(a / b > 66.66 && a / b < 66.67);
+	assert(fixp16(10000) / a == 100);
+	assert(-b == -1.5);
+	assert(-fixp(2) == -2);
+	assert(1 + b == 2.5 && b - 1 == 0.5);
+	fixp big = 500000;
+	assert(big * big / big == big); // the product takes 86 bits before the shift
+
+	assert(fixp16(fixp(1.5)) == 1.5);
+	assert(fixp(fixp16(-2.25)) == -2.25);
+	assert(fixp16(fixp(-0.1)).val == fixp(-0.1).val >> 8);
+	assert((fixed<8, int16_t>(fixp16(3.5)) == 3.5));
+
+	assert(fixp_sqrt(fixp16(2)).val == 92681); // floor(sqrt(2) * 65536)
+	assert(fixp_sqrt(fixp16(16)) == 4);
+	assert(fixp_rsqrt(fixp16(4)) == 0.5);
+	using q15 = fixed<15, int32_t>; // odd fraction bits
+	assert(fixp_rsqrt(q15(4)) == 0.5);
+	assert(fixp_rsqrt(q15(0.25)) == 2);
+	for (int32_t i = 1; i < 100000; i += 7)
+	{
+		q15 x; x.val = i;
+		const uint64_t r = fixp_rsqrt(x).val;
+		const __uint128_t one = (__uint128_t)1 << 46; // 2^(3F + 1) with x doubled
+		assert((__uint128_t)r * r * (2 * (uint64_t)i) <= one && (__uint128_t)(r + 1) * (r + 1) * (2 * (uint64_t)i) > one);
+	}
+	const ivec2_16 n = fixp_normal(ivec2_16{ 3, -4 });
+	assert(n.x == fixp16(0.6) && n.y == fixp16(-0.8));
+	assert(fixp_length(ivec2_16{ 3, 4 }) == 5);
+	assert(fixp_distance(ivec2_16{ 1, 1 }, ivec2_16{ 4, 5 }) == 5);
+	assert(fixp_dot(ivec2_16{ 2, 3 }, ivec2_16{ 4, 5 }) == 23);
+	assert(fixp_overlaps(aabb16{ { 0, 0 }, { 2, 2 } }, aabb16{ { 1, 1 }, { 3, 3 } }));
+	assert(!fixp_overlaps(aabb16{ { 0, 0 }, { 2, 2 } }, aabb16{ { 3, 3 }, { 4, 4 } }));
+	assert((aabb16{ { 0, 0 }, { 2, 4 } }.center().y == 2));
+	assert(fixp_pow(fixp16(1.5), 2) == 2.25);
+	assert(fabs(fixp_asin(fixp16(0.5)).todouble() - asin(0.5)) < 0.0002);
+}
+
+// The divider must agree with operator/ everywhere, also where the quotient overflows and wraps around
+template<typename T> static void test_divider()
+{
+	using S = typename T::storage;
+	constexpr int bits = sizeof(S) * 8;
+	uint64_t state = 1;
+	std::vector<S> values = { 1, -1, 2, -2, 3, 7, 1000, std::numeric_limits<S>::max(), std::numeric_limits<S>::min(), (S)(std::numeric_limits<S>::max() - 1),
+		(S)T::multiplier, (S)-T::multiplier, (S)(T::multiplier + 1), (S)(T::multiplier - 1) };
+	for (int i = 1; i < bits - 1; i++) { values.push_back((S)1 << i); values.push_back(((S)1 << i) - 1); values.push_back(-((S)1 << i) + 1); }
+	for (int i = 0; i < 200; i++) values.push_back((S)((int64_t)xorshift64(state) >> (xorshift64(state) % bits)));
+	for (S dv : values)
+	{
+		if (dv == 0) continue;
+		T d; d.val = dv;
+		const fixed_divider<T> div(d);
+		for (S xv : values)
+		{
+			T x; x.val = xv;
+			assert(div.divide(x) == x / d);
+		}
+	}
+	std::vector<T> in(values.size()), out(values.size());
+	for (size_t i = 0; i < values.size(); i++) in[i].val = values[i];
+	const fixed_divider<T> div(T(3) / 7);
+	div.divide_n(in.data(), out.data(), in.size());
+	for (size_t i = 0; i < in.size(); i++) assert(out[i] == in[i] / (T(3) / 7));
+}
+
 int main()
 {
+	test_layouts();
+	test_divider<fixp>();
+	test_divider<fixp16>();
+	test_divider<fixed<20, int64_t>>();
+	assert(fixp_divider(fixp(4)).divide(fixp(1)) == 0.25);
+
 	fixp f1 = 1;
 	fixp f2 = 1.5;
 	fixp f3 = 1.75f;
@@ -99,5 +184,48 @@ int main()
 	assert(normp.x == normf1);
 	assert(normp.y == normf2);
 
+	// Integer square roots, checked against the definition of a floor over the whole range
+	uint64_t state = 1234;
+	for (int i = 0; i < 200000; i++)
+	{
+		fixp x;
+		x.val = xorshift64(state) >> (1 + i % 63);
+		const __uint128_t v = (__uint128_t)x.val << fraction_bits;
+		const __uint128_t r = fixp_sqrt(x).val;
+		assert(r * r <= v && (r + 1) * (r + 1) > v);
+		if (x.val == 0) continue;
+		const __uint128_t q = fixp_rsqrt(x).val;
+		const __uint128_t one = (__uint128_t)1 << (3 * fraction_bits);
+		assert(q * q * x.val <= one && (q + 1) * (q + 1) * x.val > one);
+	}
+	fixp fmax; fmax.val = INT64_MAX;
+	assert(fixp_sqrt(fmax).val == 12439554047901ll); // floor(sqrt((2^63 - 1) * 2^24))
+	assert(fixp_sqrt(0) == 0);
+	assert(fixp_sqrt(4) == 2);
+	assert(fixp_sqrt(0.25) == 0.5);
+	assert(fixp_rsqrt(4) == 0.5);
+	assert(fixp_rsqrt(0.25) == 2);
+	fixp ulp; ulp.val = 1;
+	assert(fixp_rsqrt(ulp).val == 1ll << 36);
+
+	// Normals, against double, for short and long vectors, within one unit of rounding
+	for (int i = 0; i < 100000; i++)
+	{
+		ivec2 v;
+		const int shift = 1 + i % 40;
+		v.x.val = (int64_t)xorshift64(state) >> shift;
+		v.y.val = (int64_t)xorshift64(state) >> shift;
+		const double len = hypot((double)v.x.val, (double)v.y.val);
+		const ivec2 n = fixp_normal(v);
+		assert(llabs(n.x.val - (int64_t)(v.x.val / len * fp_multiplier)) <= 1);
+		assert(llabs(n.y.val - (int64_t)(v.y.val / len * fp_multiplier)) <= 1);
+	}
+	const ivec2 zero = fixp_normal(ivec2{ 0, 0 });
+	assert(zero.x == 0 && zero.y == 0);
+	const ivec2 down = fixp_normal(ivec2{ 0, -3 });
+	assert(down.x == 0 && down.y == -1);
+	const ivec2 tri = fixp_normal(ivec2{ -3, 4 });
+	assert(tri.x == fixp(-0.6) && tri.y == fixp(0.8));
+
 	return 0;
 }
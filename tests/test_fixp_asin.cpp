@@ -1,7 +1,9 @@
 #include "fixp.h"
 
 #include <assert.h>
+#include <stdio.h>
 #include <cmath>
+#include <vector>
 
 static void check(fixp result, double expected, double tol)
 {
@@ -9,6 +11,46 @@ static void check(fixp result, double expected, double tol)
 	assert(r > expected - tol && r < expected + tol);
 }
 
+// Max and mean error against std::asin over all of [-1, 1], and the time per call, for one accuracy tier. Timings are only meaningful in
+// an optimized build.
+template<fixp_accuracy A, typename T> static double report(const char* name)
+{
+	const int n = 1 << 16;
+	std::vector<T> in(n + 1), out(n + 1);
+	for (int i = 0; i <= n; i++) in[i].val = (typename T::storage)(((int64_t)(2 * i - n) * T::multiplier) / n);
+	double worst = 0, sum = 0;
+	for (int i = 0; i <= n; i++)
+	{
+		const double e = std::abs(fixp_asin<A>(in[i]).todouble() - std::asin(in[i].todouble()));
+		worst = std::max(worst, e);
+		sum += e;
+	}
+	const int rounds = 20;
+	const uint64_t start = cpu_gettime();
+	for (int r = 0; r < rounds; r++)
+	{
+		for (int i = 0; i <= n; i++) out[i] = fixp_asin<A>(in[i]);
+		asm volatile("" : : "r,m"(out[r]) : "memory");
+	}
+	const double ns = (double)(cpu_gettime() - start) / ((double)rounds * (n + 1));
+	printf("%-8s %2d fraction bits: max error %.3g, mean error %.3g, %.2f ns/op\n", name, T::fraction_bits, worst, sum / (n + 1), ns);
+	return worst;
+}
+
+// Max error of both fixp_asin and fixp_acos over every 'step'th raw value in [-1, 1]
+template<fixp_accuracy A, typename T> static double max_error(int64_t step)
+{
+	double worst = 0;
+	for (int64_t v = -(int64_t)T::multiplier; v <= (int64_t)T::multiplier; v += step)
+	{
+		T x;
+		x.val = (typename T::storage)v;
+		worst = std::max(worst, std::abs(fixp_asin<A>(x).todouble() - std::asin(x.todouble())));
+		worst = std::max(worst, std::abs(fixp_acos<A>(x).todouble() - std::acos(x.todouble())));
+	}
+	return worst;
+}
+
 int main()
 {
 	const double tol = 0.0002;
@@ -25,5 +67,34 @@ int main()
 	check(fixp_asin(fixp(0.9)),   asin(0.9),     tol);
 	check(fixp_asin(fixp(-0.9)),  asin(-0.9),    tol);
 
+	// Call these outside of assert, so that the report is printed in release builds too
+	const double fast = report<fixp_accuracy::fast, fixp>("fast");
+	const double normal = report<fixp_accuracy::normal, fixp>("normal");
+	const double precise = report<fixp_accuracy::precise, fixp>("precise");
+	assert(fast < 4e-4 && normal < 1e-4 && precise < 1e-6);
+	// With 16 fraction bits, rounding in each step adds up to a few 1e-5
+	const double fast16 = report<fixp_accuracy::fast, fixp16>("fast");
+	const double normal16 = report<fixp_accuracy::normal, fixp16>("normal");
+	const double precise16 = report<fixp_accuracy::precise, fixp16>("precise");
+	assert(fast16 < 4e-4 && normal16 < 1.5e-4 && precise16 < 1e-4);
+
+	// The bounds documented on fixp_accuracy. Every input for fixp takes too long in a debug build, so take every 61st there; the documented
+	// values come from a full sweep.
+	const double fast_max = max_error<fixp_accuracy::fast, fixp>(61);
+	const double normal_max = max_error<fixp_accuracy::normal, fixp>(61);
+	const double precise_max = max_error<fixp_accuracy::precise, fixp>(61);
+	assert(fast_max < 3.3e-4 && normal_max < 7e-5 && precise_max < 3.8e-7);
+	const double precise16_max = max_error<fixp_accuracy::precise, fixp16>(1);
+	assert(precise16_max < 8.5e-5);
+
+	// All tiers are exact enough at the ends, and asin and acos agree
+	for (fixp x : { fixp(-1), fixp(0), fixp(1) })
+	{
+		check(fixp_asin<fixp_accuracy::fast>(x), asin(x.todouble()), 1e-3);
+		check(fixp_acos<fixp_accuracy::fast>(x), acos(x.todouble()), 1e-3);
+		check(fixp_asin<fixp_accuracy::precise>(x), asin(x.todouble()), 1e-6);
+		check(fixp_acos<fixp_accuracy::precise>(x), acos(x.todouble()), 1e-6);
+	}
+
 	return 0;
 }
@@ -0,0 +1,76 @@
+#include "fixp_soa.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+template<typename T> static void fill(fixed_vec2_soa<T>& v, uint64_t& state, int shift)
+{
+	for (size_t i = 0; i < v.size(); i++)
+	{
+		fixed_vec2<T> p;
+		p.x.val = (typename T::storage)((int64_t)xorshift64(state) >> shift);
+		p.y.val = (typename T::storage)((int64_t)xorshift64(state) >> shift);
+		v.set(i, p);
+	}
+}
+
+// Every kernel must give exactly what the scalar operators give, also when the products wrap around
+template<typename T> static void test_kernels(int shift)
+{
+	uint64_t state = 42 + shift;
+	const size_t n = 1001;
+	fixed_vec2_soa<T> a(n), b(n);
+	fill(a, state, shift);
+	fill(b, state, shift);
+	std::vector<T> out(n);
+
+	fixp_dot_n(a, b, out.data());
+	for (size_t i = 0; i < n; i++) assert(out[i] == fixp_dot(a.get(i), b.get(i)));
+	fixp_length_sq_n(a, out.data());
+	for (size_t i = 0; i < n; i++) assert(out[i] == fixp_dot(a.get(i), a.get(i)));
+	fixp_distance_sq_n(a, b, out.data());
+	for (size_t i = 0; i < n; i++) { const T dx = a.get(i).x - b.get(i).x; const T dy = a.get(i).y - b.get(i).y; assert(out[i] == dx * dx + dy * dy); }
+	const fixed_vec2<T> p = b.get(7);
+	fixp_distance_sq_n(a, p, out.data());
+	for (size_t i = 0; i < n; i++) { const T dx = a.get(i).x - p.x; const T dy = a.get(i).y - p.y; assert(out[i] == dx * dx + dy * dy); }
+
+	fixed_vec2_soa<T> pos = a;
+	T dt; dt.val = (typename T::storage)((int64_t)xorshift64(state) >> shift);
+	fixp_axpy_n(pos, b, dt);
+	for (size_t i = 0; i < n; i++) { assert(pos.get(i).x == a.get(i).x + b.get(i).x * dt); assert(pos.get(i).y == a.get(i).y + b.get(i).y * dt); }
+	dt = T(1) / 60;
+	pos = a;
+	fixp_axpy_n(pos, b, dt);
+	for (size_t i = 0; i < n; i++) { assert(pos.get(i).x == a.get(i).x + b.get(i).x * dt); assert(pos.get(i).y == a.get(i).y + b.get(i).y * dt); }
+
+	fixed_aabb<T> box { { -10, -5 }, { 20, 7.5 } };
+	fixp_clamp_n(pos, box);
+	for (size_t i = 0; i < n; i++)
+	{
+		const fixed_vec2<T> q = pos.get(i);
+		assert(q.x >= box.min.x && q.x <= box.max.x && q.y >= box.min.y && q.y <= box.max.y);
+		assert(q.x == std::clamp(a.get(i).x + b.get(i).x * dt, box.min.x, box.max.x));
+		assert(q.y == std::clamp(a.get(i).y + b.get(i).y * dt, box.min.y, box.max.y));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const cpu_level best = cpu_level_detect();
+	for (int level = 0; level <= (int)best; level++)
+	{
+		cpu_level_set((cpu_level)level);
+		for (int shift : { 1, 20, 34, 40, 50 }) test_kernels<fixp>(shift);
+		for (int shift : { 33, 40, 45, 50 }) test_kernels<fixp16>(shift);
+	}
+	cpu_level_set(best);
+	for (int shift : { 1, 30, 50 }) test_kernels<fixed<20, int64_t>>(shift); // not dispatched, uses the templates
+
+	ivec2_soa v;
+	v.push_back(ivec2{ 1, 2 });
+	v.push_back(ivec2{ -3, 4.5 });
+	assert(v.size() == 2 && v.get(1).x == -3 && v.get(1).y == 4.5);
+	assert((fixed_mul_raw<24, int64_t>(fixp(-1.5).val, fixp(2).val) == fixp(-3).val));
+	assert((fixed_mul_raw<24, int64_t, true>(fixp(-1.5).val, fixp(2).val) == fixp(-3).val));
+	return 0;
+}
@@ -0,0 +1,128 @@
+#include "fixp.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <cmath>
+#include <vector>
+
+// Signed difference between two directions, in direction units
+static double direction_error(direction d, double radians)
+{
+	double e = d - radians * 65536.0 / (2.0 * M_PI);
+	e = std::fmod(e, 65536.0);
+	if (e > 32768.0) e -= 65536.0;
+	if (e < -32768.0) e += 65536.0;
+	return std::abs(e);
+}
+
+template<typename T> static void test_sincos(double tol)
+{
+	double worst = 0;
+	for (uint32_t i = 0; i < 65536; i++)
+	{
+		const direction d = i;
+		const double a = i * 2.0 * M_PI / 65536.0;
+		worst = std::max(worst, std::abs(fixp_sin<T>(d).todouble() - sin(a)));
+		worst = std::max(worst, std::abs(fixp_cos<T>(d).todouble() - cos(a)));
+	}
+	printf("fixp_sin/fixp_cos (%d fraction bits): max error %g\n", T::fraction_bits, worst);
+	assert(worst <= tol);
+	assert(fixp_sin<T>(0) == T(0));
+	assert(fixp_cos<T>(0) == T(1));
+	assert(fixp_sin<T>(16384) == T(1));
+	assert(fixp_cos<T>(32768) == T(-1));
+	assert(fixp_sin<T>(49152) == T(-1));
+}
+
+template<typename T> static void test_atan2(double range)
+{
+	// Points all the way around the circle, at several scales, including ones where the ratio needs more than 32 bits
+	double worst = 0;
+	for (int s = 0; s < 3; s++)
+	{
+		const double radius = s == 0 ? 1e-3 : s == 1 ? 1.0 : range;
+		for (uint32_t i = 0; i < 65536; i += 7)
+		{
+			const double a = i * 2.0 * M_PI / 65536.0 + 1e-4;
+			const T x(radius * cos(a));
+			const T y(radius * sin(a));
+			worst = std::max(worst, direction_error(fixp_atan2(y, x), atan2(y.todouble(), x.todouble())));
+		}
+	}
+	printf("fixp_atan2 (%d fraction bits): max error %g directions\n", T::fraction_bits, worst);
+	assert(worst <= 1.0);
+
+	// Exact on the axes and diagonals
+	const T one(1), zero(0);
+	assert(fixp_atan2(zero, zero) == 0);
+	assert(fixp_atan2(zero, one) == 0);
+	assert(fixp_atan2(one, one) == 8192);
+	assert(fixp_atan2(one, zero) == 16384);
+	assert(fixp_atan2(one, -one) == 24576);
+	assert(fixp_atan2(zero, -one) == 32768);
+	assert(fixp_atan2(-one, -one) == 40960);
+	assert(fixp_atan2(-one, zero) == 49152);
+	assert(fixp_atan2(-one, one) == 57344);
+
+	// Round trip through a unit vector
+	for (uint32_t i = 0; i < 65536; i += 97)
+	{
+		const int diff = (int16_t)(direction)(fixp_atan2(fixp_sin<T>(i), fixp_cos<T>(i)) - i);
+		assert(std::abs(diff) <= 6); // most of it from isin, which is off by up to 2^-11, or about 5 directions
+	}
+}
+
+static void test_acos()
+{
+	double worst = 0;
+	for (int i = -4096; i <= 4096; i++)
+	{
+		const fixp x(i / 4096.0);
+		worst = std::max(worst, std::abs(fixp_acos(x).todouble() - acos(x.todouble())));
+		assert(std::abs((fixp_acos(x) + fixp_asin(x)).todouble() - M_PI / 2) < 2e-7); // they agree with each other
+	}
+	printf("fixp_acos: max error %g\n", worst);
+	assert(worst <= 1e-4);
+	assert(std::abs(fixp_acos(fixp(-1)).todouble() - M_PI) < 1e-4);
+}
+
+static void test_conversions()
+{
+	assert(fixp_to_direction(fixp(0)) == 0);
+	assert(fixp_to_direction(fixp(M_PI / 2)) == 16384);
+	assert(fixp_to_direction(fixp(M_PI)) == 32768);
+	assert(fixp_to_direction(fixp(-M_PI / 2)) == 49152);
+	assert(fixp_to_direction(fixp(5 * M_PI / 2)) == 16384);
+	for (uint32_t i = 0; i < 65536; i += 13) assert(fixp_to_direction(fixp_radians(i)) == i);
+}
+
+template<typename T> static void test_arrays()
+{
+	const int n = 1000;
+	std::vector<direction> dirs(n);
+	std::vector<T> s(n), c(n), in(n), out(n);
+	std::vector<direction> back(n);
+	for (int i = 0; i < n; i++) { dirs[i] = i * 65537u / 7; in[i] = T((i - n / 2) / (double)(n / 2)); }
+	fixp_sincos_n(dirs.data(), s.data(), c.data(), n);
+	fixp_atan2_n(s.data(), c.data(), back.data(), n);
+	fixp_acos_n(in.data(), out.data(), n);
+	for (int i = 0; i < n; i++)
+	{
+		assert(s[i] == fixp_sin<T>(dirs[i]) && c[i] == fixp_cos<T>(dirs[i]));
+		assert(back[i] == fixp_atan2(s[i], c[i]));
+		assert(out[i] == fixp_acos(in[i]));
+	}
+}
+
+int main()
+{
+	test_sincos<fixp>(1.0 / 2048);
+	test_sincos<fixp16>(1.0 / 2048);
+	test_atan2<fixp>(1e9);
+	test_atan2<fixp16>(3e4);
+	test_acos();
+	test_conversions();
+	test_arrays<fixp>();
+	test_arrays<fixp16>();
+	return 0;
+}
@@ -0,0 +1,92 @@
+#include "dice.h"
+#include "instrument.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+static void roll_some(seed& s, int count)
+{
+	DICEY_SCOPE_HERE();
+	for (int i = 0; i < count; i++) (void)s.roll(1, 6);
+}
+
+static void test_draws()
+{
+	seed s(42);
+	const uint64_t before = instrument_draws;
+	(void)s.roll(1, 6);
+	(void)s.roll(1, 6, luck_type::lucky); // best of two
+	assert(instrument_draws - before == 3);
+
+	instrument_reset();
+	{
+		DICEY_SCOPE("outer");
+		roll_some(s, 10);
+		{
+			DICEY_SCOPE("inner");
+			roll_some(s, 5);
+		}
+	}
+	std::thread worker([]{ seed t(7); roll_some(t, 20); });
+	worker.join();
+
+	char* buf = nullptr;
+	size_t len = 0;
+	FILE* fp = open_memstream(&buf, &len);
+	instrument_write_table(fp);
+	fclose(fp);
+	printf("%s", buf);
+	assert(strstr(buf, "outer"));
+	assert(strstr(buf, "inner"));
+	const char* line = strstr(buf, "roll_some");
+	assert(line);
+	unsigned long long calls = 0, draws = 0;
+	int fields = sscanf(line, "roll_some %llu %llu", &calls, &draws);
+	assert(fields == 2);
+	assert(calls == 3); // two calls on this thread and one on the worker, merged by name
+	assert(draws == 35);
+	line = strstr(buf, "outer");
+	fields = sscanf(line, "outer %llu %llu", &calls, &draws);
+	assert(fields == 2);
+	assert(calls == 1 && draws == 15); // nested draws count toward every open scope
+	line = strstr(buf, "inner");
+	fields = sscanf(line, "inner %llu %llu", &calls, &draws);
+	assert(fields == 2);
+	assert(calls == 1 && draws == 5);
+	free(buf);
+}
+
+static void test_library_scopes()
+{
+	instrument_reset();
+	seed s(42);
+	roll_table rt(s, { 1, 10, 100, 1000 });
+	int results[4];
+	rt.rolls(4, results);
+	linear_series ls(s, 100);
+	uint32_t out[10];
+	ls.roll_n(10, out);
+
+	const char* path = "test_instrument_trace.json";
+	const bool written = instrument_write_trace(path);
+	assert(written);
+	FILE* fp = fopen(path, "r");
+	assert(fp);
+	char buf[4096];
+	const size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+	buf[len] = '\0';
+	fclose(fp);
+	remove(path);
+	assert(strncmp(buf, "{\"traceEvents\":[", 16) == 0);
+	assert(strstr(buf, "\"name\":\"roll_table::rolls\""));
+	assert(strstr(buf, "\"name\":\"linear_series::roll_n\""));
+	assert(strstr(buf, "\"ph\":\"X\""));
+}
+
+int main(int argc, char **argv)
+{
+	test_draws();
+	test_library_scopes();
+	return 0;
+}
@@ -0,0 +1,203 @@
+#include "noise.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static void test_hash()
+{
+	seed s(42);
+	const uint64_t key = noise_key(s);
+	for (int64_t x = -20; x < 20; x += 3)
+	{
+		for (int64_t y = -20; y < 20; y += 7)
+		{
+			assert(noise_hash(key, x, y) == s.derive(x, y).orig);
+			assert(noise_hash(key, x, y, x * y) == s.derive(x, y, x * y).orig);
+		}
+	}
+	assert(noise_key(s, 3) == splitmix64(s.derive(3).orig));
+}
+
+static void test_fade()
+{
+	assert(noise_fade(0) == 0);
+	assert(noise_fade(65536) == 65536);
+	assert(noise_fade(32768) == 32768);
+	int32_t prev = 0;
+	for (int32_t t = 0; t <= 65536; t += 64)
+	{
+		assert(noise_fade(t) >= prev);
+		prev = noise_fade(t);
+	}
+}
+
+static void test_lattice()
+{
+	seed s(7);
+	const uint64_t key = noise_key(s);
+	for (int32_t x = -5; x < 5; x++)
+	{
+		for (int32_t y = -5; y < 5; y++)
+		{
+			const int16_t v = value_noise2(s, x << 4, y << 4, 4);
+			assert(v == noise_to_int16(noise_value(noise_hash(key, x, y))));
+			assert(gradient_noise2(s, x << 4, y << 4, 4) == 0);
+			assert(gradient_noise3(s, x << 4, y << 4, 3 << 4, 4) == 0);
+			assert(value_noise2(s, fixp(x), fixp(y)).val == (int64_t)noise_value(noise_hash(key, x, y)) << (fraction_bits - 16));
+		}
+	}
+}
+
+static void test_smooth()
+{
+	seed s(9);
+	for (const noise_type type : { noise_type::value, noise_type::gradient })
+	{
+		int64_t sum = 0;
+		int lo = 0, hi = 0;
+		for (int32_t y = -100; y < 100; y++)
+		{
+			for (int32_t x = -100; x < 100; x++)
+			{
+				const int16_t n = (type == noise_type::value) ? value_noise2(s, x, y, 5) : gradient_noise2(s, x, y, 5);
+				const int16_t right = (type == noise_type::value) ? value_noise2(s, x + 1, y, 5) : gradient_noise2(s, x + 1, y, 5);
+				const int16_t down = (type == noise_type::value) ? value_noise2(s, x, y + 1, 5) : gradient_noise2(s, x, y + 1, 5);
+				assert(abs(n - right) < 6000 && abs(n - down) < 6000); // no seams between cells
+				sum += n;
+				lo = std::min<int>(lo, n);
+				hi = std::max<int>(hi, n);
+			}
+		}
+		printf("%s noise: mean %.1f range %d to %d\n", type == noise_type::value ? "value" : "gradient", sum / 40000.0, lo, hi);
+		assert(lo < -10000 && hi > 10000);
+		assert(llabs(sum / 40000) < 5000);
+	}
+	for (int32_t z = 0; z < 64; z++)
+	{
+		assert(abs(value_noise3(s, 3, 5, z, 4) - value_noise3(s, 3, 5, z + 1, 4)) < 8000);
+		assert(abs(gradient_noise3(s, 3, 5, z, 4) - gradient_noise3(s, 3, 5, z + 1, 4)) < 8000);
+	}
+}
+
+static void test_tiles()
+{
+	seed s(1234);
+	struct { int32_t x0, y0; int w, h, shift; } cases[] = { { 0, 0, 16, 16, 3 }, { -37, -5, 50, 9, 4 }, { 1000, -2000, 33, 1, 6 }, { -3, 7, 1, 20, 0 }, { -100, -100, 64, 64, 8 } };
+	for (const auto& c : cases)
+	{
+		std::vector<int16_t> tile((size_t)c.w * c.h);
+		for (const noise_type type : { noise_type::value, noise_type::gradient })
+		{
+			noise2_tile(s, type, c.x0, c.y0, c.w, c.h, c.shift, tile.data());
+			for (int j = 0; j < c.h; j++)
+			{
+				for (int i = 0; i < c.w; i++)
+				{
+					const int16_t n = (type == noise_type::value) ? value_noise2(s, c.x0 + i, c.y0 + j, c.shift) : gradient_noise2(s, c.x0 + i, c.y0 + j, c.shift);
+					assert(tile[j * c.w + i] == n);
+				}
+			}
+			const int octaves = std::min(c.shift + 1, 4);
+			fbm2_tile(s, type, c.x0, c.y0, c.w, c.h, c.shift, octaves, tile.data());
+			for (int j = 0; j < c.h; j++)
+			{
+				for (int i = 0; i < c.w; i++) assert(tile[j * c.w + i] == fbm2(s, c.x0 + i, c.y0 + j, c.shift, octaves, type));
+			}
+		}
+	}
+}
+
+static void test_fbm()
+{
+	seed s(5);
+	assert(fbm2(s, 13, 17, 6, 1, noise_type::value) == value_noise2(s, 13, 17, 6)); // one octave is just the noise
+	assert(fbm2(s, fixp(1.5), fixp(2.25), 1) == gradient_noise2(s, fixp(1.5), fixp(2.25)));
+	assert(fbm3(s, 1, 2, 3, 5, 1) == gradient_noise3(s, 1, 2, 3, 5));
+	assert(noise_amplitude(0, 32768) == 65536 && noise_amplitude(3, 32768) == 8192);
+	const fixp f = fbm3(s, fixp(0.3), fixp(-7.7), fixp(11.1), 5);
+	assert(f >= fixp(-1) && f <= fixp(1));
+}
+
+static void test_blue_noise()
+{
+	seed s(77);
+	const fixp radius = fixp(2.5);
+	const int cells = 16;
+	std::vector<ivec2> all;
+	ivec2 buf[cells * cells];
+	for (int32_t cy = -2; cy < 2; cy++)
+	{
+		for (int32_t cx = -2; cx < 2; cx++)
+		{
+			const int n = blue_noise_chunk(s, cx, cy, cells, radius, buf);
+			for (int i = 0; i < n; i++)
+			{
+				// every point is inside its own chunk
+				assert(buf[i].x >= radius * fixp(cx * cells) && buf[i].x < radius * fixp((cx + 1) * cells));
+				assert(buf[i].y >= radius * fixp(cy * cells) && buf[i].y < radius * fixp((cy + 1) * cells));
+				all.push_back(buf[i]);
+			}
+			assert(n == blue_noise_chunk(s, cx, cy, cells, radius, buf)); // deterministic
+		}
+	}
+	const double density = (double)all.size() / (16 * cells * cells);
+	printf("blue noise: %d points, %.2f per cell\n", (int)all.size(), density);
+	assert(density > 0.3 && density < 0.6);
+
+	// no two points closer than the radius, also across chunk borders; allow a few units of rounding when scaling to world coordinates
+	const int64_t r = radius.val - 4;
+	for (size_t i = 0; i < all.size(); i++)
+	{
+		for (size_t j = i + 1; j < all.size(); j++)
+		{
+			const int64_t dx = all[i].x.val - all[j].x.val;
+			const int64_t dy = all[i].y.val - all[j].y.val;
+			if (llabs(dx) >= r || llabs(dy) >= r) continue;
+			assert(dx * dx + dy * dy >= r * r);
+		}
+	}
+
+	// seamless: one big chunk gives exactly the points of the four small chunks it covers
+	std::vector<ivec2> big(4 * cells * cells);
+	const int n = blue_noise_chunk(s, 0, 0, 2 * cells, radius, big.data());
+	big.resize(n);
+	std::vector<ivec2> small;
+	for (int32_t cy = 0; cy < 2; cy++) for (int32_t cx = 0; cx < 2; cx++) { const int m = blue_noise_chunk(s, cx, cy, cells, radius, buf); small.insert(small.end(), buf, buf + m); }
+	auto less = [](const ivec2& a, const ivec2& b) { return a.y < b.y || (a.y == b.y && a.x < b.x); };
+	std::sort(big.begin(), big.end(), less);
+	std::sort(small.begin(), small.end(), less);
+	assert(big.size() == small.size());
+	for (size_t i = 0; i < big.size(); i++) assert(big[i].x == small[i].x && big[i].y == small[i].y);
+}
+
+// Fixed outputs, so that we notice if results change between compilers or platforms
+static void test_golden()
+{
+	seed s(1);
+	uint64_t hash = 0;
+	for (int32_t i = -50; i < 50; i++)
+	{
+		hash = hash * 31 + (uint16_t)value_noise2(s, i * 7, i * 13, 5);
+		hash = hash * 31 + (uint16_t)gradient_noise2(s, i * 7, i * 13, 5);
+		hash = hash * 31 + (uint16_t)value_noise3(s, i * 7, i * 13, i, 5);
+		hash = hash * 31 + (uint16_t)gradient_noise3(s, i * 7, i * 13, i, 5);
+		hash = hash * 31 + (uint16_t)fbm2(s, i * 7, i * 13, 5, 4);
+		hash = hash * 31 + (uint64_t)fbm2(s, fixp(i) / 3, fixp(i) / 5, 3).val;
+	}
+	printf("golden hash %llu\n", (unsigned long long)hash);
+	assert(hash == 9260769661148344262ull);
+}
+
+int main(int argc, char **argv)
+{
+	test_hash();
+	test_fade();
+	test_lattice();
+	test_smooth();
+	test_tiles();
+	test_fbm();
+	test_blue_noise();
+	test_golden();
+	return 0;
+}
@@ -0,0 +1,79 @@
+#include "dice.h"
+#include <assert.h>
+#include <stdio.h>
+
+static uint64_t histogram_sum(const rejection_stats& st)
+{
+	uint64_t sum = 0;
+	for (uint64_t h : st.histogram) sum += h;
+	return sum;
+}
+
+static void test_linear_series()
+{
+	seed s(42);
+	linear_series full(s, 1023); // no rerolls possible
+	for (int i = 0; i < 5000; i++) (void)full.roll();
+	assert(full.stats().calls == 5000);
+	assert(full.stats().attempts == 5000);
+	assert(full.stats().max == 1);
+	assert(full.stats().histogram[0] == 5000);
+
+	linear_series sparse(s, 1025); // almost half of each LFSR period is rerolled
+	for (int i = 0; i < 5000; i++) (void)sparse.roll();
+	const rejection_stats& st = sparse.stats();
+	assert(st.calls == 5000);
+	assert(histogram_sum(st) == st.calls);
+	assert(st.mean() > 1.5 && st.mean() < 2.5);
+	assert(st.max > 1);
+	printf("linear_series(1025): mean %.2f max %llu\n", st.mean(), (unsigned long long)st.max);
+	sparse.reset_stats();
+	assert(sparse.stats().calls == 0 && sparse.stats().max == 0);
+
+	// the batched path must count the same attempts as rolling one by one
+	for (const int n : { 10, 100, 1000, 3000 })
+	{
+		linear_series a(s, 1500), b(s, 1500);
+		std::vector<uint32_t> out(n);
+		a.roll_n(n, out.data());
+		for (int i = 0; i < n; i++) (void)b.roll();
+		assert(a.stats().calls == b.stats().calls);
+		assert(a.stats().attempts == b.stats().attempts);
+	}
+
+	integer_prd prd(s, 1, 6, 60);
+	for (int i = 0; i < 100; i++) (void)prd.roll();
+	assert(prd.stats().calls == 100);
+}
+
+static void test_roll_table()
+{
+	seed s(42);
+	roll_table rt(s, { 1000, 1, 1, 1 });
+	int results[4];
+	assert(rt.unique_rolls(4, results) == 4);
+	const rejection_stats& u = rt.stats().unique_rolls;
+	assert(u.calls == 4);
+	assert(u.attempts >= 4);
+	assert(u.max > 1); // the rare entries take many rolls once the common one is taken
+	assert(histogram_sum(u) == u.calls);
+	printf("unique_rolls: attempts %llu max %llu\n", (unsigned long long)u.attempts, (unsigned long long)u.max);
+
+	roll_table box(s, { 1, 1, 1, 1, 1, 1, 1, 1 });
+	for (int i = 0; i < 8; i++) assert(box.boxgacha() >= 0);
+	assert(box.boxgacha() == -1); // empty table is not a scan
+	const rejection_stats& b = box.stats().boxgacha;
+	assert(b.calls == 8);
+	assert(b.attempts >= 8);
+	assert(b.max <= 8);
+	printf("boxgacha: attempts %llu max %llu\n", (unsigned long long)b.attempts, (unsigned long long)b.max);
+	box.reset_stats();
+	assert(box.stats().boxgacha.calls == 0);
+}
+
+int main(int argc, char **argv)
+{
+	test_linear_series();
+	test_roll_table();
+	return 0;
+}